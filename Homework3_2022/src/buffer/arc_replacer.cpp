@@ -0,0 +1,243 @@
+/**
+ * ARC implementation
+ */
+#include <algorithm>
+
+#include "buffer/arc_replacer.h"
+
+namespace scudb {
+using namespace std;
+    template <typename T>
+    ARCReplacer<T>::ARCReplacer(size_t capacity, uint64_t correlated_period)
+            : mCapacity(capacity), mCorrelatedPeriod(correlated_period),
+              mClock(0), mTarget(0), mSize(0) {}
+
+    template <typename T> ARCReplacer<T>::~ARCReplacer() {}
+
+/*
+ * A frame got unpinned. If it holds the page we already track, this is a hit
+ * and the frame moves to the front of T2 (or stays where it is for a
+ * correlated reference). Otherwise the page just came in: a ghost hit adapts
+ * the target and goes to T2, a cold miss goes to T1.
+ */
+    template <typename T> void ARCReplacer<T>::Insert(const T &value) {
+        Reference(value, false);
+    }
+
+/*
+ * A page read ahead goes in like a miss, and stays in its list when it is
+ * first used
+ */
+    template <typename T>
+    void ARCReplacer<T>::InsertPrefetched(const T &value) {
+        Reference(value, true);
+    }
+
+    template <typename T>
+    void ARCReplacer<T>::Reference(const T &value, bool prefetched) {
+        lock_guard<mutex> lck(mLatch);
+        // a read-ahead is not a reference, it must not break up the
+        // correlated references of other frames either
+        if (!prefetched) {
+            mClock++;
+        }
+        int64_t key = ArcKeyOf(value);
+        auto it = mEntries.find(value);
+        if (it != mEntries.end() && it->second.key != key) {
+            // the old page left this frame without being victimized (deleted)
+            (it->second.list == eList::T1 ? mT1 : mT2).erase(it->second.pos);
+            if (it->second.evictable) {
+                mSize--;
+            }
+            mEntries.erase(it);
+            it = mEntries.end();
+        }
+
+        if (it != mEntries.end()) {
+            sEntry &entry = it->second;
+            std::list<T> &from = entry.list == eList::T1 ? mT1 : mT2;
+            bool correlated = entry.prefetched ||
+                              mClock - entry.last_ref <= mCorrelatedPeriod;
+            std::list<T> &to = correlated ? from : mT2;
+            to.splice(to.begin(), from, entry.pos);
+            entry.list = (&to == &mT1) ? eList::T1 : eList::T2;
+            entry.last_ref = mClock;
+            entry.prefetched = prefetched;
+            if (!entry.evictable) {
+                entry.evictable = true;
+                mSize++;
+            }
+            return;
+        }
+
+        eList list = eList::T1;
+        auto ghost = mGhosts.find(key);
+        if (ghost != mGhosts.end()) {
+            if (ghost->second.first == eList::T1) {
+                size_t delta = max<size_t>(mB2.size() / mB1.size(), 1);
+                mTarget = min(mCapacity, mTarget + delta);
+                RemoveGhost(mB1, key);
+            } else {
+                size_t delta = max<size_t>(mB1.size() / mB2.size(), 1);
+                mTarget = mTarget > delta ? mTarget - delta : 0;
+                RemoveGhost(mB2, key);
+            }
+            list = eList::T2;
+        }
+        std::list<T> &to = list == eList::T1 ? mT1 : mT2;
+        to.push_front(value);
+        mEntries[value] = sEntry{list, to.begin(), key, mClock, true, prefetched};
+        mSize++;
+        TrimGhosts();
+    }
+
+/*
+ * Evict from T1 while it is above its target, from T2 otherwise; fall back to
+ * the other list when every frame in the preferred one is pinned. Return false
+ * if every frame is
+ */
+    template <typename T> bool ARCReplacer<T>::Victim(T &value) {
+        lock_guard<mutex> lck(mLatch);
+        if (mSize == 0) {
+            return false;
+        }
+        std::list<T> &first = PreferT1() ? mT1 : mT2;
+        std::list<T> &second = PreferT1() ? mT2 : mT1;
+        return EvictFrom(first, value) || EvictFrom(second, value);
+    }
+
+/*
+ * Pin: the page stays resident, it just cannot be evicted. Return true if it
+ * was evictable before this call
+ */
+    template <typename T> bool ARCReplacer<T>::Erase(const T &value) {
+        lock_guard<mutex> lck(mLatch);
+        auto it = mEntries.find(value);
+        if (it == mEntries.end() || !it->second.evictable) {
+            return false;
+        }
+        it->second.evictable = false;
+        mSize--;
+        return true;
+    }
+
+    template <typename T> size_t ARCReplacer<T>::Size() {
+        lock_guard<mutex> lck(mLatch);
+        return mSize;
+    }
+
+    template <typename T> size_t ARCReplacer<T>::GetTargetSize() {
+        lock_guard<mutex> lck(mLatch);
+        return mTarget;
+    }
+
+    template <typename T> void ARCReplacer<T>::SetCapacity(size_t capacity) {
+        lock_guard<mutex> lck(mLatch);
+        mCapacity = capacity;
+        mTarget = min(mTarget, mCapacity);
+        TrimGhosts();
+    }
+
+/*
+ * Evictable frames in the order Victim would pick them, assuming the target
+ * does not move in between
+ */
+    template <typename T>
+    void ARCReplacer<T>::Candidates(vector<T> &out, size_t n) {
+        lock_guard<mutex> lck(mLatch);
+        std::list<T> &first = PreferT1() ? mT1 : mT2;
+        std::list<T> &second = PreferT1() ? mT2 : mT1;
+        for (std::list<T> *list : {&first, &second}) {
+            for (auto pos = list->rbegin(); pos != list->rend() && n > 0; ++pos) {
+                if (mEntries[*pos].evictable && !this->IsPinned(*pos)) {
+                    out.push_back(*pos);
+                    n--;
+                }
+            }
+        }
+    }
+
+    template <typename T> bool ARCReplacer<T>::Evict(const T &value) {
+        lock_guard<mutex> lck(mLatch);
+        auto it = mEntries.find(value);
+        if (it == mEntries.end() || !it->second.evictable) {
+            return false;
+        }
+        EvictEntry(it);
+        return true;
+    }
+
+    template <typename T> void ARCReplacer<T>::Forget(const T &value) {
+        lock_guard<mutex> lck(mLatch);
+        auto it = mEntries.find(value);
+        if (it == mEntries.end()) {
+            return;
+        }
+        if (it->second.evictable) {
+            mSize--;
+        }
+        (it->second.list == eList::T1 ? mT1 : mT2).erase(it->second.pos);
+        mEntries.erase(it);
+    }
+
+/*
+ * Evict the least recently used evictable frame of list. Caller must hold
+ * mLatch
+ */
+    template <typename T>
+    bool ARCReplacer<T>::EvictFrom(std::list<T> &list, T &value) {
+        for (auto pos = list.rbegin(); pos != list.rend(); ++pos) {
+            auto it = mEntries.find(*pos);
+            if (it->second.evictable && !this->IsPinned(*pos)) {
+                value = *pos;
+                EvictEntry(it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+/*
+ * Drop a resident frame and remember its page in the matching ghost list.
+ * Caller must hold mLatch
+ */
+    template <typename T>
+    void ARCReplacer<T>::EvictEntry(
+            typename unordered_map<T, sEntry>::iterator it) {
+        eList list = it->second.list;
+        std::list<int64_t> &ghost = list == eList::T1 ? mB1 : mB2;
+        int64_t key = it->second.key;
+        (list == eList::T1 ? mT1 : mT2).erase(it->second.pos);
+        mEntries.erase(it);
+        mSize--;
+        ghost.push_front(key);
+        mGhosts[key] = make_pair(list, ghost.begin());
+        TrimGhosts();
+    }
+
+    template <typename T>
+    void ARCReplacer<T>::RemoveGhost(std::list<int64_t> &ghost, int64_t key) {
+        auto it = mGhosts.find(key);
+        ghost.erase(it->second.second);
+        mGhosts.erase(it);
+    }
+
+/*
+ * Keep the directory within the bounds of the paper:
+ * |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c
+ */
+    template <typename T> void ARCReplacer<T>::TrimGhosts() {
+        while (!mB1.empty() && mT1.size() + mB1.size() > mCapacity) {
+            RemoveGhost(mB1, mB1.back());
+        }
+        while (!mB2.empty() &&
+               mT1.size() + mT2.size() + mB1.size() + mB2.size() > 2 * mCapacity) {
+            RemoveGhost(mB2, mB2.back());
+        }
+    }
+
+    template class ARCReplacer<Page *>;
+// test only
+    template class ARCReplacer<int>;
+
+} // namespace scudb
@@ -0,0 +1,46 @@
+/**
+ * striped buffer pool counters implementation
+ */
+#include <cstdlib>
+#include <new>
+
+#include "buffer/buffer_pool_counters.h"
+
+namespace scudb {
+using namespace std;
+    BufferPoolCounters::BufferPoolCounters() {
+        void *memory = nullptr;
+        if (posix_memalign(&memory, CACHE_LINE_SIZE,
+                           NUM_STRIPES * sizeof(Stripe)) != 0) {
+            throw bad_alloc();
+        }
+        stripes_ = static_cast<Stripe *>(memory);
+        for (size_t i = 0; i < NUM_STRIPES; ++i) {
+            for (size_t j = 0; j < NUM_VALUES; ++j) {
+                new (&stripes_[i].values[j]) atomic<size_t>(0);
+            }
+        }
+    }
+
+    BufferPoolCounters::~BufferPoolCounters() { free(stripes_); }
+
+    size_t BufferPoolCounters::Get(BufferPoolCounter counter) const {
+        size_t sum = 0;
+        for (size_t i = 0; i < NUM_STRIPES; ++i) {
+            sum += stripes_[i].values[static_cast<size_t>(counter)].load(
+                    memory_order_relaxed);
+        }
+        return sum;
+    }
+
+/*
+ * Stripe of the calling thread, handed out round robin on first use
+ */
+    size_t BufferPoolCounters::ThreadStripe() {
+        static atomic<size_t> next_stripe(0);
+        thread_local size_t stripe =
+                next_stripe.fetch_add(1, memory_order_relaxed) % NUM_STRIPES;
+        return stripe;
+    }
+
+} // namespace scudb
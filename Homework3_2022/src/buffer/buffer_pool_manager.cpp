@@ -1,35 +1,106 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
 #include "buffer/buffer_pool_manager.h"
 
 namespace scudb {
 using namespace std;
+
+    const size_t BufferPoolManager::PREFETCH_BATCH;
+
 /*
  * BufferPoolManager Constructor
  * When log_manager is nullptr, logging is disabled (for test purpose)
- * WARNING: Do Not Edit This Function
+ * replacer_type picks the replacement policy for unpinned frames
  */
     BufferPoolManager::BufferPoolManager(size_t pool_size,
                                          DiskManager *disk_manager,
-                                         LogManager *log_manager)
-            : pool_size_(pool_size), disk_manager_(disk_manager),
-              log_manager_(log_manager) {
-        // a consecutive memory space for buffer pool
-        pages_ = new Page[pool_size_];
-        page_table_ = new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE);
-        replacer_ = new LRUReplacer<Page *>;
+                                         LogManager *log_manager,
+                                         ReplacerType replacer_type,
+                                         size_t max_pool_size)
+            : pool_size_(0), max_pool_size_(max(pool_size, max_pool_size)),
+              page_size_(disk_manager->GetPageSize()),
+              disk_manager_(disk_manager), log_manager_(log_manager) {
+        // descriptors for every frame the pool may grow to, in an array of
+        // their own so pin counts and latches do not share cache lines with
+        // page data; each frame in use has a page aligned buffer of the page
+        // size of the db file
+        void *memory = nullptr;
+        if (posix_memalign(&memory, CACHE_LINE_SIZE,
+                           max<size_t>(max_pool_size_, 1) * sizeof(Page)) != 0) {
+            throw bad_alloc();
+        }
+        pages_ = static_cast<Page *>(memory);
+        for (size_t i = 0; i < max_pool_size_; ++i) {
+            new (&pages_[i]) Page();
+            pages_[i].page_size_ = page_size_;
+            pages_[i].pin_count_ = -1;
+        }
+        page_table_ = new PageTable(max_pool_size_);
+        switch (replacer_type) {
+            case ReplacerType::CLOCK:
+                replacer_ = new ClockReplacer<Page *>(pages_, max_pool_size_);
+                break;
+            case ReplacerType::LRU_K:
+                replacer_ = new LRUKReplacer<Page *>;
+                break;
+            case ReplacerType::ARC:
+                replacer_ = new ARCReplacer<Page *>(pool_size);
+                break;
+            case ReplacerType::LRU:
+            default:
+                replacer_ = new LRUReplacer<Page *>;
+                break;
+        }
+        // hits pin frames without erasing them from the replacer
+        replacer_->SetPinnedCheck(
+                [](Page *const &page) { return page->GetPinCount() > 0; });
         free_list_ = new std::list<Page *>;
 
         // put all the pages into free list
-        for (size_t i = 0; i < pool_size_; ++i) {
-            free_list_->push_back(&pages_[i]);
+        for (size_t i = 0; i < pool_size; ++i) {
+            if (!ActivateFrame(&pages_[i])) {
+                for (size_t j = 0; j < max_pool_size_; ++j) {
+                    free(pages_[j].data_);
+                    pages_[j].~Page();
+                }
+                free(pages_);
+                delete page_table_;
+                delete replacer_;
+                delete free_list_;
+                throw bad_alloc();
+            }
         }
     }
 
+/*
+ * Constructor for managers that own no frames (e.g. the parallel manager,
+ * which forwards every request to one of its instances)
+ */
+    BufferPoolManager::BufferPoolManager(DiskManager *disk_manager,
+                                         LogManager *log_manager)
+            : pool_size_(0), max_pool_size_(0),
+              page_size_(disk_manager->GetPageSize()), pages_(nullptr),
+              disk_manager_(disk_manager),
+              log_manager_(log_manager), page_table_(nullptr),
+              replacer_(nullptr), free_list_(nullptr) {}
+
 /*
  * BufferPoolManager Deconstructor
- * WARNING: Do Not Edit This Function
+ * Stops the background threads first, they use the frames. Dirty pages are
+ * not written, callers flush before deleting the pool
  */
     BufferPoolManager::~BufferPoolManager() {
-        delete[] pages_;
+        StopCleanerThread();
+        StopPrefetchThread();
+        // a manager without frames of its own may still report a pool size
+        for (size_t i = 0; pages_ != nullptr && i < max_pool_size_; ++i) {
+            free(pages_[i].data_);
+            pages_[i].~Page();
+        }
+        free(pages_);
         delete page_table_;
         delete replacer_;
         delete free_list_;
@@ -46,32 +117,66 @@ using namespace std;
  * 4. Update page metadata, read page content from disk file and return page
  * pointer
  *
- * This function must mark the Page as pinned and remove its entry from LRUReplacer before it is returned to the caller.
+ * This function must mark the Page as pinned before it is returned to the
+ * caller, and returns nullptr if the page cannot be read (an I/O error or a
+ * checksum mismatch). A hit finds and pins the frame without taking any lock and leaves
+ * it in the replacer (which passes over pinned frames); latch_ is taken for
+ * misses, and by a hit on a page that is still being read.
  */
-    Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-        lock_guard<mutex> lck(latch_);
-        Page *tar = nullptr;
-        if (page_table_->Find(page_id,tar)) { //1.1
-            tar->pin_count_++;
-            replacer_->Erase(tar);
+    Page *BufferPoolManager::FetchPage(page_id_t page_id,
+                                       BufferAccessStrategy *strategy) {
+        Page *tar = PinPage(page_id);
+        if (tar != nullptr) { //1.1
+            counters_.Add(BufferPoolCounter::HITS);
+            if (strategy != nullptr) {
+                strategy->hits_++;
+            }
+            if (tar->io_state_ != Page::IOState::NONE ||
+                tar->page_id_ != page_id) {
+                // another request is bringing the page in, wait for it
+                // instead of reading it again
+                unique_lock<mutex> lck = LockLatch();
+                tar->io_cv_.wait(lck, [&] { return tar->io_state_ == Page::IOState::NONE; });
+                if (tar->page_id_ != page_id) {
+                    return ReleaseFailedLoad(tar);
+                }
+            }
+            return tar;
+        }
+
+        unique_lock<mutex> lck = LockLatch();
+        tar = PinPage(page_id);
+        if (tar == nullptr && writing_.count(page_id) != 0) {
+            // evicted while its content is being written back, read it after
+            WaitForWrite(page_id, lck);
+            tar = PinPage(page_id);
+        }
+        if (tar != nullptr) { // brought in since we looked
+            counters_.Add(BufferPoolCounter::HITS);
+            if (strategy != nullptr) {
+                strategy->hits_++;
+            }
+            tar->io_cv_.wait(lck, [&] { return tar->io_state_ == Page::IOState::NONE; });
+            if (tar->page_id_ != page_id) {
+                return ReleaseFailedLoad(tar);
+            }
             return tar;
         }
         //1.2
-        tar = GetVictimPage();
+        tar = strategy == nullptr ? GetVictimPage() : GetRingVictim(strategy);
         if (tar == nullptr) return tar;
-        //2
-        if (tar->is_dirty_) {
-            disk_manager_->WritePage(tar->GetPageId(),tar->data_);
+        counters_.Add(BufferPoolCounter::MISSES);
+        //2-4
+        if (ReplaceFrame(tar, page_id, true, lck) == nullptr) {
+            return nullptr;
+        }
+        if (strategy != nullptr) {
+            strategy->misses_++;
+            if (!strategy->ring_.empty()) {
+                strategy->ring_[strategy->next_] = make_pair(tar, page_id);
+                strategy->next_ = (strategy->next_ + 1) % strategy->ring_.size();
+            }
         }
-        //3
-        page_table_->Remove(tar->GetPageId());
-        page_table_->Insert(page_id,tar);
-        //4
-        disk_manager_->ReadPage(page_id,tar->data_);
-        tar->pin_count_ = 1;
-        tar->is_dirty_ = false;
-        tar->page_id_= page_id;
-
         return tar;
     }
 //Page *BufferPoolManager::find
@@ -83,22 +188,29 @@ using namespace std;
  * dirty flag of this page
  */
     bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-        lock_guard<mutex> lck(latch_);
-        Page *tar = nullptr;
-        page_table_->Find(page_id,tar);
+        // the caller's pin keeps the frame on page_id, so no lock is needed
+        // unless the lookup raced with a Remove moving the entry
+        Page *tar = FindPage(page_id);
+        if (tar == nullptr) {
+            unique_lock<mutex> lck = LockLatch();
+            tar = FindPage(page_id);
+        }
         if (tar == nullptr) {
             return false;
         }
-        tar->is_dirty_ |= is_dirty;
+        if (is_dirty) {
+            tar->is_dirty_ = true;
+        }
 
         if (tar->GetPinCount() <= 0) {
 //    cout<<"error "<<tar->GetPageId()<<endl;
             assert(false);
             return false;
         }
-        ;
         //std::cout<<"page id :"<<page_id<<"pin count"<<tar->pin_count_<<endl;
         if (--tar->pin_count_ == 0) {
+            // the frame may hold another page by now, the replacer then just
+            // sees a frame that is pinned or unpinned again
             replacer_->Insert(tar);
         }
         return true;
@@ -111,48 +223,149 @@ using namespace std;
  * NOTE: make sure page_id != INVALID_PAGE_ID
  */
     bool BufferPoolManager::FlushPage(page_id_t page_id) {
-        lock_guard<mutex> lck(latch_);
-        Page *tar = nullptr;
-        page_table_->Find(page_id,tar);
+        unique_lock<mutex> lck = LockLatch();
+        // an earlier write of the page must land first
+        WaitForWrite(page_id, lck);
+        Page *tar = FindPage(page_id);
         if (tar == nullptr || tar->page_id_ == INVALID_PAGE_ID) {
             return false;
         }
-        if (tar->is_dirty_) {
-            disk_manager_->WritePage(page_id,tar->GetData());
+        if (tar->is_dirty_ && tar->io_state_ == Page::IOState::NONE) {
+            // write a copy, the frame may be evicted once latch_ is released
+            AlignedBuffer copy(page_size_, GetBufferAlignment());
+            memcpy(copy.GetData(), tar->GetData(), page_size_);
             tar->is_dirty_ = false;
+            writing_.insert(page_id);
+            lck.unlock();
+            disk_manager_->WritePage(page_id, copy.GetData());
+            counters_.Add(BufferPoolCounter::WRITE_BACKS);
+            lck.lock();
+            writing_.erase(writing_.find(page_id));
+            written_cv_.notify_all();
         }
 
         return true;
     }
 
+/*
+ * Copy every dirty page and mark it clean, then write the copies with latch_
+ * released as one batch: runs of consecutive page ids go out as single
+ * vectored writes, and one fdatasync makes the whole checkpoint durable.
+ * Writes already under way go first, so an older version of a page cannot
+ * land after the copy taken here
+ */
+    void BufferPoolManager::FlushAllPages() {
+        unique_lock<mutex> lck = LockLatch();
+        written_cv_.wait(lck, [&] { return writing_.empty(); });
+        vector<Page *> dirty;
+        for (size_t i = 0; i < max_pool_size_; ++i) {
+            if (pages_[i].page_id_ != INVALID_PAGE_ID && pages_[i].is_dirty_ &&
+                pages_[i].io_state_ == Page::IOState::NONE) {
+                dirty.push_back(&pages_[i]);
+            }
+        }
+        if (dirty.empty()) {
+            return;
+        }
+        AlignedBuffer buffer(dirty.size() * page_size_, GetBufferAlignment());
+        vector<DiskManager::PageWrite> batch;
+        for (Page *page : dirty) {
+            char *copy = buffer.GetData() + batch.size() * page_size_;
+            memcpy(copy, page->data_, page_size_);
+            page->is_dirty_ = false;
+            writing_.insert(page->page_id_);
+            batch.emplace_back(page->page_id_, copy);
+        }
+
+        lck.unlock();
+        disk_manager_->WritePages(batch, true);
+        lck.lock();
+
+        for (auto &entry : batch) {
+            writing_.erase(writing_.find(entry.first));
+        }
+        counters_.Add(BufferPoolCounter::WRITE_BACKS, batch.size());
+        written_cv_.notify_all();
+    }
+
 /**
  * User should call this method for deleting a page. This routine will call
  * disk manager to deallocate the page. First, if page is found within page
  * table, buffer pool manager should be reponsible for removing this entry out
  * of page table, reseting page metadata and adding back to free list. Second,
  * call disk manager's DeallocatePage() method to delete from disk file. If
- * the page is found within page table, but pin_count != 0, return false
+ * the page is found within page table, but pin_count != 0, return false.
+ * The disk manager puts the page on its free list by writing to it, so
+ * writes of the page still in flight have to land before
  */
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
-    lock_guard<mutex> lck(latch_);
-    Page *tar = nullptr;
-    page_table_->Find(page_id,tar);
+    unique_lock<mutex> lck = LockLatch();
+    WaitForWrite(page_id, lck);
+    Page *tar = FindPage(page_id);
     if (tar != nullptr) {
-        if (tar->GetPinCount() > 0) {
+        if (!ClaimFrame(tar)) {
             //     cout<<"DeletePage error"<<tar->page_id_<<endl;
 //      assert(false);
             return false;
         }
-        replacer_->Erase(tar);
-        page_table_->Remove(page_id);
+        FreeFrame(tar);
+    }
+    disk_manager_->DeallocatePage(page_id);
+    counters_.Add(BufferPoolCounter::DELETE_PAGES);
+    return true;
+}
+
+/*
+ * Drop a tablespace: free the frames of its pages, dirty or not, and have
+ * the disk manager delete the file
+ */
+    bool BufferPoolManager::DropFile(int file_id) {
+        return DiscardFile(file_id) && disk_manager_->DropFile(file_id);
+    }
+
+/*
+ * Free the frame of every page of file_id once its writes in flight have
+ * landed, and forget prefetches of them; false if one of them is pinned
+ */
+    bool BufferPoolManager::DiscardFile(int file_id) {
+        auto in_file = [file_id](page_id_t page_id) {
+            return page_id != INVALID_PAGE_ID &&
+                   DiskManager::GetFileId(page_id) == file_id;
+        };
+        unique_lock<mutex> lck = LockLatch();
+        written_cv_.wait(lck, [&] {
+            return none_of(writing_.begin(), writing_.end(), in_file);
+        });
+        prefetch_queue_.erase(remove_if(prefetch_queue_.begin(),
+                                        prefetch_queue_.end(), in_file),
+                              prefetch_queue_.end());
+        bool ok = true;
+        for (size_t i = 0; i < max_pool_size_; ++i) {
+            Page *tar = &pages_[i];
+            if (in_file(tar->page_id_)) {
+                if (ClaimFrame(tar)) {
+                    FreeFrame(tar);
+                } else {
+                    ok = false;
+                }
+            }
+        }
+        return ok;
+    }
+
+/*
+ * Put a claimed frame on the free list, dropping its page. Caller must hold
+ * latch_
+ */
+    void BufferPoolManager::FreeFrame(Page *tar) {
+        replacer_->Forget(tar);
         tar->is_dirty_= false;
         tar->ResetMemory();
         tar->page_id_ = INVALID_PAGE_ID;
+        // the pin count stays -1 until the frame is reused: a hit that looked
+        // the page up before it was deleted must not pin the free frame
         free_list_->push_back(tar);
     }
-    disk_manager_->DeallocatePage(page_id);
-    return true;
-}
 
 /**
  * User should call this method if needs to create a new page. This routine
@@ -160,57 +373,703 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) {
  * Buffer pool manager should be responsible to choose a victim page either
  * from free list or lru replacer(NOTE: always choose from free list first),
  * update new page's metadata, zero out memory and add corresponding entry
- * into page table. return nullptr if all the pages in pool are pinned
+ * into page table. return nullptr if all the pages in pool are pinned, or the
+ * disk manager has no page id left
  */
-    Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-        lock_guard<mutex> lck(latch_);
+    Page *BufferPoolManager::NewPage(page_id_t &page_id, PageExtent *extent) {
+        counters_.Add(BufferPoolCounter::NEW_PAGES);
+        unique_lock<mutex> lck = LockLatch();
         Page *tar = nullptr;
         tar = GetVictimPage();
         if (tar == nullptr) {
             return tar;
         }
 
-        page_id = disk_manager_->AllocatePage();
-        //2
-        if (tar->is_dirty_) {
-            disk_manager_->WritePage(tar->GetPageId(),tar->data_);
+        page_id = disk_manager_->AllocatePage(extent);
+        if (page_id == INVALID_PAGE_ID) {
+            ReleaseVictim(tar);
+            return nullptr;
         }
-        //3
-        page_table_->Remove(tar->GetPageId());
-        page_table_->Insert(page_id,tar);
+        return InstallNewPage(tar, page_id, lck);
+    }
 
-        //4
-        tar->page_id_ = page_id;
-        tar->ResetMemory();
+/*
+ * Give back a frame from GetVictimPage that is not used after all: a free
+ * frame goes back on the free list, a claimed one gets its page back as it
+ * was. Caller must hold latch_
+ */
+    void BufferPoolManager::ReleaseVictim(Page *tar) {
+        if (tar->page_id_ == INVALID_PAGE_ID) {
+            free_list_->push_front(tar);
+            return;
+        }
+        page_table_->Insert(tar->page_id_, static_cast<frame_id_t>(tar - pages_));
+        tar->pin_count_ = 0;
+        replacer_->Insert(tar);
+    }
+
+/*
+ * Same as NewPage, but the page id has already been allocated by the caller.
+ * Return nullptr if all the pages in pool are pinned
+ */
+    Page *BufferPoolManager::NewPageWithId(page_id_t page_id) {
+        unique_lock<mutex> lck = LockLatch();
+        Page *tar = GetVictimPage();
+        if (tar == nullptr) {
+            return tar;
+        }
+        return InstallNewPage(tar, page_id, lck);
+    }
+
+/*
+ * Reset the victim frame to hold the new page_id, zeroed. A reused page id
+ * may still have a frame, read ahead after the page was deleted; that one is
+ * dropped. Caller must hold latch_ through lck
+ */
+    Page *BufferPoolManager::InstallNewPage(Page *tar, page_id_t page_id,
+                                            unique_lock<mutex> &lck) {
+        Page *stale = FindPage(page_id);
+        if (stale != nullptr && ClaimFrame(stale)) {
+            FreeFrame(stale);
+        }
+        return ReplaceFrame(tar, page_id, false, lck);
+    }
+
+/*
+ * Give the victim frame tar to page_id, pinned once. The page table is
+ * updated first and the frame marked LOADING (or WRITING when only the old
+ * content has to go out), then the old content is written back if dirty and
+ * the new one read if load is set, both with latch_ released. Requests for
+ * page_id meanwhile find the frame and wait on it, requests for the old page
+ * wait until it is written. If the read fails the frame is freed and
+ * nullptr returned. Caller must hold latch_ through lck.
+ */
+    Page *BufferPoolManager::ReplaceFrame(Page *tar, page_id_t page_id,
+                                          bool load, unique_lock<mutex> &lck) {
+        page_id_t old_page_id = tar->GetPageId();
+        if (old_page_id != INVALID_PAGE_ID) {
+            counters_.Add(BufferPoolCounter::EVICTIONS);
+        }
+        bool write_back = tar->is_dirty_;
+        //3 the old entry went when the victim was claimed
         tar->is_dirty_ = false;
+        if (!write_back && !load) {
+            tar->ResetMemory();
+        } else {
+            tar->io_state_ = load ? Page::IOState::LOADING : Page::IOState::WRITING;
+        }
+        // the page id goes first: a hit that pins the frame from now on must
+        // see it to tell the frame changed hands
+        tar->page_id_ = page_id;
         tar->pin_count_ = 1;
+        page_table_->Insert(page_id, static_cast<frame_id_t>(tar - pages_));
+        if (!write_back && !load) {
+            return tar;
+        }
+        if (write_back) {
+            counters_.Add(BufferPoolCounter::SYNC_WRITES);
+            counters_.Add(BufferPoolCounter::WRITE_BACKS);
+            // queue up right away so nobody reads the old page back, but let
+            // an earlier write of it (cleaner, FlushPage) land first
+            writing_.insert(old_page_id);
+            written_cv_.wait(lck, [&] { return writing_.count(old_page_id) == 1; });
+        }
+
+        lck.unlock();
+        //2
+        if (write_back) {
+            // no sync, the requester is waiting; checkpoints make it durable
+            vector<DiskManager::PageWrite> batch{{old_page_id, tar->data_}};
+            disk_manager_->WritePages(batch);
+        }
+        //4
+        bool loaded = true;
+        if (load) {
+            loaded = disk_manager_->ReadPage(page_id,tar->data_) ||
+                     PastEndOfFile(tar, page_id);
+        } else {
+            tar->ResetMemory();
+        }
+        lck.lock();
+
+        if (write_back) {
+            writing_.erase(writing_.find(old_page_id));
+            written_cv_.notify_all();
+        }
+        if (!loaded) {
+            AbandonLoad(tar, page_id, lck);
+            return nullptr;
+        }
+        tar->io_state_ = Page::IOState::NONE;
+        tar->io_cv_.notify_all();
+        return tar;
+    }
+
+/*
+ * A read of page_id into tar failed because the page lies past the end of its
+ * file: it was allocated but never written (a clean new page was evicted), so
+ * it is a page of zeros. False if the page is in the file, and the read
+ * failed on an I/O error or a checksum mismatch
+ */
+    bool BufferPoolManager::PastEndOfFile(Page *tar, page_id_t page_id) {
+        int file_id = DiskManager::GetFileId(page_id);
+        if (DiskManager::GetPageNo(page_id) <
+            disk_manager_->GetNumPages(file_id)) {
+            return false;
+        }
+        tar->ResetMemory();
+        return true;
+    }
+
+/*
+ * The read of page_id into the frame tar failed, its content is not the
+ * page. The page table entry goes, and the requests that waited for the read
+ * see the frame lost its page id and let go of it (ReleaseFailedLoad); then
+ * the frame goes on the free list. Caller must hold latch_ through lck and
+ * one pin of tar
+ */
+    void BufferPoolManager::AbandonLoad(Page *tar, page_id_t page_id,
+                                        unique_lock<mutex> &lck) {
+        counters_.Add(BufferPoolCounter::READ_FAILURES);
+        page_table_->Remove(page_id);
+        tar->page_id_ = INVALID_PAGE_ID;
+        tar->io_state_ = Page::IOState::NONE;
+        tar->io_cv_.notify_all();
+        int pinned = 1;
+        while (!tar->pin_count_.compare_exchange_strong(pinned, -1)) {
+            pinned = 1;
+            // a hit that pinned the frame without the latch and found the
+            // page id changed unpins it without waking us
+            tar->io_cv_.wait_for(lck, chrono::milliseconds(1));
+        }
+        FreeFrame(tar);
+    }
+
+/*
+ * A request that pinned tar for a page whose read failed (see AbandonLoad)
+ * unpins it and gets nullptr. Caller must hold latch_
+ */
+    Page *BufferPoolManager::ReleaseFailedLoad(Page *tar) {
+        tar->pin_count_--;
+        tar->io_cv_.notify_all();
+        return nullptr;
+    }
 
+/*
+ * The frame holding page_id, if the page table has it. Without latch_ this
+ * can miss a page that is in the pool (see PageTable::Remove), and the frame
+ * can change hands right after unless the caller has it pinned
+ */
+    Page *BufferPoolManager::FindPage(page_id_t page_id) {
+        frame_id_t frame_id;
+        if (!page_table_->Find(page_id, frame_id)) {
+            return nullptr;
+        }
+        return &pages_[frame_id];
+    }
+
+/*
+ * Find page_id and pin its frame with no lock: the pin count is bumped unless
+ * the frame is claimed (negative), then the frame is checked to still hold
+ * page_id, as it may have been claimed and reused since the lookup. Return
+ * nullptr if that fails or the page is not found; under latch_ nothing is
+ * claimed concurrently and the answer is exact
+ */
+    Page *BufferPoolManager::PinPage(page_id_t page_id) {
+        Page *tar = FindPage(page_id);
+        if (tar == nullptr) {
+            return nullptr;
+        }
+        int pin_count = tar->pin_count_;
+        do {
+            if (pin_count < 0) {
+                return nullptr;
+            }
+        } while (!tar->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+        if (tar->page_id_ != page_id) {
+            if (--tar->pin_count_ == 0) {
+                // its owner may have unpinned it meanwhile and left it to us
+                replacer_->Insert(tar);
+            }
+            return nullptr;
+        }
         return tar;
     }
 
+/*
+ * Take a frame away from its page unless it is pinned (a hit may have pinned
+ * a victim since the replacer picked it): its pin count goes from 0 to -1 so
+ * no hit can pin it any more, and the page table entry is removed. The caller
+ * then gives it a new page, or sets the pin count back to 0. False for a
+ * deleted page's frame, which is on the free list. Caller must hold latch_
+ */
+    bool BufferPoolManager::ClaimFrame(Page *tar) {
+        page_id_t page_id = tar->page_id_;
+        int unpinned = 0;
+        if (page_id == INVALID_PAGE_ID ||
+            !tar->pin_count_.compare_exchange_strong(unpinned, -1)) {
+            return false;
+        }
+        page_table_->Remove(page_id);
+        return true;
+    }
+
+/*
+ * Block until no write of page_id is in flight. Caller must hold latch_
+ * through lck, which is released while waiting
+ */
+    void BufferPoolManager::WaitForWrite(page_id_t page_id,
+                                         unique_lock<mutex> &lck) {
+        written_cv_.wait(lck, [&] { return writing_.count(page_id) == 0; });
+    }
+
+/*
+ * Take a frame from the free list, else from the replacer. While a cleaner
+ * runs, prefer a clean frame among those closest to eviction and only fall
+ * back to a dirty victim (written by the caller) when there is none. A frame
+ * from the replacer is claimed before it is returned; one that got pinned in
+ * the meantime leaves the replacer until it is unpinned.
+ * Caller must hold latch_
+ */
     Page *BufferPoolManager::GetVictimPage() {
         Page *tar = nullptr;
         if (free_list_->empty()) {
             if (replacer_->Size() == 0) {
                 return nullptr;
             }
-            replacer_->Victim(tar);
+            if (clean_frames_ > 0) {
+                vector<Page *> candidates;
+                replacer_->Candidates(candidates, clean_frames_);
+                bool saw_dirty = false;
+                for (Page *page : candidates) {
+                    if (page->is_dirty_) {
+                        saw_dirty = true;
+                    } else if (replacer_->Evict(page) && ClaimFrame(page)) {
+                        tar = page;
+                        break;
+                    }
+                }
+                if (saw_dirty || tar == nullptr) {
+                    cleaner_cv_.notify_one();
+                }
+            }
+            while (tar == nullptr && replacer_->Victim(tar)) {
+                if (!ClaimFrame(tar)) {
+                    tar = nullptr;
+                }
+            }
         } else {
             tar = free_list_->front();
             free_list_->pop_front();
             assert(tar->GetPageId() == INVALID_PAGE_ID);
         }
         if (tar != nullptr) {
-            assert(tar->GetPinCount() == 0);
+            assert(tar->GetPinCount() <= 0);
         }
         return tar;
     }
 
+/*
+ * Sum up the counters and take the pin count histogram, without latch_: the
+ * numbers are not one consistent snapshot while the pool is in use
+ */
+    BufferPoolStats BufferPoolManager::GetStats() {
+        BufferPoolStats stats;
+        stats.hits = counters_.Get(BufferPoolCounter::HITS);
+        stats.misses = counters_.Get(BufferPoolCounter::MISSES);
+        stats.evictions = counters_.Get(BufferPoolCounter::EVICTIONS);
+        stats.write_backs = counters_.Get(BufferPoolCounter::WRITE_BACKS);
+        stats.sync_writes = counters_.Get(BufferPoolCounter::SYNC_WRITES);
+        stats.cleaner_writes = counters_.Get(BufferPoolCounter::CLEANER_WRITES);
+        stats.new_pages = counters_.Get(BufferPoolCounter::NEW_PAGES);
+        stats.delete_pages = counters_.Get(BufferPoolCounter::DELETE_PAGES);
+        stats.prefetches = counters_.Get(BufferPoolCounter::PREFETCHES);
+        stats.ring_reuses = counters_.Get(BufferPoolCounter::RING_REUSES);
+        stats.read_failures = counters_.Get(BufferPoolCounter::READ_FAILURES);
+        stats.latch_waits = counters_.Get(BufferPoolCounter::LATCH_WAITS);
+        stats.latch_wait_ns = counters_.Get(BufferPoolCounter::LATCH_WAIT_NS);
+        auto arc = dynamic_cast<ARCReplacer<Page *> *>(replacer_);
+        if (arc != nullptr) {
+            stats.arc_target_size = arc->GetTargetSize();
+        }
+        stats.pool_size = pool_size_;
+        // retired frames are not counted, frames in use but not pinned are
+        // whatever is left of the pool size
+        size_t pinned = 0;
+        for (size_t i = 0; i < max_pool_size_; ++i) {
+            int pin_count = pages_[i].GetPinCount();
+            int bucket = 0;
+            while (pin_count > 0 && bucket < BufferPoolStats::PIN_BUCKETS - 1) {
+                bucket++;
+                pin_count >>= 1;
+            }
+            if (bucket > 0) {
+                stats.pinned_frames[bucket]++;
+                pinned++;
+            }
+        }
+        stats.pinned_frames[0] = stats.pool_size - min(pinned, stats.pool_size);
+        return stats;
+    }
+
+    BufferPoolStats &BufferPoolStats::operator+=(const BufferPoolStats &other) {
+        hits += other.hits;
+        misses += other.misses;
+        evictions += other.evictions;
+        write_backs += other.write_backs;
+        sync_writes += other.sync_writes;
+        cleaner_writes += other.cleaner_writes;
+        new_pages += other.new_pages;
+        delete_pages += other.delete_pages;
+        prefetches += other.prefetches;
+        ring_reuses += other.ring_reuses;
+        read_failures += other.read_failures;
+        latch_waits += other.latch_waits;
+        latch_wait_ns += other.latch_wait_ns;
+        pool_size += other.pool_size;
+        arc_target_size += other.arc_target_size;
+        for (int i = 0; i < PIN_BUCKETS; ++i) {
+            pinned_frames[i] += other.pinned_frames[i];
+        }
+        return *this;
+    }
+
+/*
+ * Lock latch_; only an acquisition that has to block reads the clock
+ */
+    unique_lock<mutex> BufferPoolManager::LockLatch() {
+        unique_lock<mutex> lck(latch_, try_to_lock);
+        if (!lck.owns_lock()) {
+            auto start = chrono::steady_clock::now();
+            lck.lock();
+            counters_.Add(BufferPoolCounter::LATCH_WAITS);
+            counters_.Add(BufferPoolCounter::LATCH_WAIT_NS,
+                          chrono::duration_cast<chrono::nanoseconds>(
+                                  chrono::steady_clock::now() - start).count());
+        }
+        return lck;
+    }
+
+    void BufferPoolManager::RunCleanerThread(size_t clean_frames) {
+        unique_lock<mutex> lck = LockLatch();
+        if (cleaner_thread_ != nullptr || clean_frames == 0) {
+            return;
+        }
+        clean_frames_ = min<size_t>(clean_frames, pool_size_);
+        cleaner_buffer_.Reserve(clean_frames_ * page_size_,
+                                GetBufferAlignment());
+        cleaner_stop_ = false;
+        cleaner_thread_ = new thread(&BufferPoolManager::CleanerLoop, this);
+    }
+
+/*
+ * Stop and join the cleaner thread, a batch being written is finished first
+ */
+    void BufferPoolManager::StopCleanerThread() {
+        thread *cleaner = nullptr;
+        {
+            unique_lock<mutex> lck = LockLatch();
+            cleaner = cleaner_thread_;
+            cleaner_thread_ = nullptr;
+            cleaner_stop_ = true;
+            clean_frames_ = 0;
+        }
+        if (cleaner != nullptr) {
+            cleaner_cv_.notify_one();
+            cleaner->join();
+            delete cleaner;
+        }
+    }
+
+/*
+ * Clean a batch, then sleep until a miss finds dirty frames near eviction or
+ * CLEANER_TIMEOUT passes
+ */
+    void BufferPoolManager::CleanerLoop() {
+        unique_lock<mutex> lck = LockLatch();
+        while (!cleaner_stop_) {
+            CleanBatch(lck);
+            if (!cleaner_stop_) {
+                cleaner_cv_.wait_for(lck, CLEANER_TIMEOUT);
+            }
+        }
+    }
+
+/*
+ * Copy the dirty pages among the next clean_frames_ victims and mark them
+ * clean, then write the copies with latch_ released as one batch, which the
+ * disk manager writes in page id order with adjacent pages merged. Until the
+ * batch is written the pages are listed in writing_ and must not be read back
+ * from disk. The batch gets one fdatasync, so a page the cleaner wrote is
+ * durable before its frame counts as clean.
+ */
+    void BufferPoolManager::CleanBatch(unique_lock<mutex> &lck) {
+        vector<Page *> candidates;
+        replacer_->Candidates(candidates, clean_frames_);
+        vector<DiskManager::PageWrite> batch;
+        for (Page *page : candidates) {
+            page_id_t page_id = page->page_id_;
+            int unpinned = 0;
+            // a pin count of -1 keeps hits from pinning (and changing) the
+            // page during the copy, they wait for latch_ instead
+            if (!page->is_dirty_ || writing_.count(page_id) != 0 ||
+                !page->pin_count_.compare_exchange_strong(unpinned, -1)) {
+                continue;
+            }
+            char *copy = cleaner_buffer_.GetData() + batch.size() * page_size_;
+            memcpy(copy, page->data_, page_size_);
+            page->is_dirty_ = false;
+            page->pin_count_ = 0;
+            writing_.insert(page_id);
+            batch.emplace_back(page_id, copy);
+        }
+        if (batch.empty()) {
+            return;
+        }
+
+        lck.unlock();
+        disk_manager_->WritePages(batch, true);
+        lck.lock();
+
+        for (auto &entry : batch) {
+            writing_.erase(writing_.find(entry.first));
+        }
+        counters_.Add(BufferPoolCounter::CLEANER_WRITES, batch.size());
+        counters_.Add(BufferPoolCounter::WRITE_BACKS, batch.size());
+        written_cv_.notify_all();
+    }
+
+    void BufferPoolManager::Prefetch(page_id_t first, size_t n) {
+        int file_id = DiskManager::GetFileId(first);
+        page_id_t end = min<page_id_t>(
+                first + n, DiskManager::MakePageId(
+                        file_id, disk_manager_->GetNumPages(file_id)));
+        unique_lock<mutex> lck = LockLatch();
+        for (page_id_t page_id = first;
+             page_id < end && prefetch_queue_.size() < pool_size_; ++page_id) {
+            if (FindPage(page_id) == nullptr) {
+                prefetch_queue_.push_back(page_id);
+            }
+        }
+        if (prefetch_queue_.empty()) {
+            return;
+        }
+        if (prefetch_thread_ == nullptr) {
+            prefetch_stop_ = false;
+            prefetch_thread_ = new thread(&BufferPoolManager::PrefetchLoop, this);
+        }
+        prefetch_cv_.notify_one();
+    }
+
+    void BufferPoolManager::StopPrefetchThread() {
+        thread *prefetcher = nullptr;
+        {
+            unique_lock<mutex> lck = LockLatch();
+            prefetcher = prefetch_thread_;
+            prefetch_thread_ = nullptr;
+            prefetch_stop_ = true;
+            prefetch_queue_.clear();
+        }
+        if (prefetcher != nullptr) {
+            prefetch_cv_.notify_one();
+            prefetcher->join();
+            delete prefetcher;
+        }
+    }
+
+/*
+ * Read queued pages up to PREFETCH_BATCH at a time, with asynchronous reads
+ * that are all in flight together. Each is loaded like a FetchPage miss (a
+ * request for it meanwhile waits on the frame) and then left unpinned in the
+ * replacer, which does not take the load for a use of the page.
+ */
+    void BufferPoolManager::PrefetchLoop() {
+        unique_lock<mutex> lck = LockLatch();
+        while (true) {
+            prefetch_cv_.wait(lck, [&] {
+                return prefetch_stop_ || !prefetch_queue_.empty();
+            });
+            if (prefetch_stop_) {
+                break;
+            }
+            // frames read with asynchronous I/O, all in flight at once; they
+            // stay pinned until the batch is done, so leave half the pool to
+            // the requests that asked for the read-ahead
+            size_t batch = min(PREFETCH_BATCH, max<size_t>(pool_size_ / 2, 1));
+            vector<Page *> loading;
+            vector<page_id_t> loading_ids;
+            vector<IOCompletion> reads;
+            while (!prefetch_queue_.empty() && loading.size() < batch) {
+                page_id_t page_id = prefetch_queue_.front();
+                prefetch_queue_.pop_front();
+                if (FindPage(page_id) != nullptr ||
+                    writing_.count(page_id) != 0) {
+                    continue;
+                }
+                Page *tar = GetVictimPage();
+                if (tar == nullptr) {
+                    // every frame is pinned, reading ahead would not help now
+                    prefetch_queue_.clear();
+                    break;
+                }
+                counters_.Add(BufferPoolCounter::PREFETCHES);
+                if (tar->is_dirty_) {
+                    // the old content has to go out first, as on a miss
+                    if (ReplaceFrame(tar, page_id, true, lck) != nullptr &&
+                        --tar->pin_count_ == 0) {
+                        replacer_->InsertPrefetched(tar);
+                    }
+                    continue;
+                }
+                // ReplaceFrame without the read, see there
+                if (tar->page_id_ != INVALID_PAGE_ID) {
+                    counters_.Add(BufferPoolCounter::EVICTIONS);
+                }
+                tar->io_state_ = Page::IOState::LOADING;
+                tar->page_id_ = page_id;
+                tar->pin_count_ = 1;
+                page_table_->Insert(page_id, static_cast<frame_id_t>(tar - pages_));
+                reads.push_back(disk_manager_->ReadPageAsync(page_id, tar->data_));
+                loading.push_back(tar);
+                loading_ids.push_back(page_id);
+            }
+            if (loading.empty()) {
+                continue;
+            }
+
+            lck.unlock();
+            vector<bool> loaded;
+            for (size_t i = 0; i < reads.size(); ++i) {
+                loaded.push_back(reads[i].get() ||
+                                 PastEndOfFile(loading[i], loading_ids[i]));
+            }
+            lck.lock();
+
+            for (size_t i = 0; i < loading.size(); ++i) {
+                Page *tar = loading[i];
+                if (!loaded[i]) {
+                    // not installed: requests that found the frame get nullptr
+                    AbandonLoad(tar, loading_ids[i], lck);
+                    continue;
+                }
+                tar->io_state_ = Page::IOState::NONE;
+                tar->io_cv_.notify_all();
+                if (--tar->pin_count_ == 0) {
+                    replacer_->InsertPrefetched(tar);
+                }
+            }
+        }
+    }
+
+/*
+ * Frames beyond pool_size are retired one at a time: a free frame if there
+ * is one, else a victim of the replacer. Frames go back on the free list when
+ * the pool grows, so they are used before anything is evicted
+ */
+    size_t BufferPoolManager::Resize(size_t pool_size) {
+        lock_guard<mutex> resize_lck(resize_latch_);
+        unique_lock<mutex> lck = LockLatch();
+        pool_size = min(pool_size, max_pool_size_);
+        for (size_t i = 0; pool_size_ < pool_size && i < max_pool_size_; ++i) {
+            if (pages_[i].data_ == nullptr && !ActivateFrame(&pages_[i])) {
+                break;
+            }
+        }
+        while (pool_size_ > pool_size) {
+            Page *tar = nullptr;
+            if (!free_list_->empty()) {
+                tar = free_list_->front();
+                free_list_->pop_front();
+            } else {
+                while (replacer_->Victim(tar) && !ClaimFrame(tar)) {
+                    tar = nullptr;
+                }
+            }
+            if (tar == nullptr) {
+                // every frame left is pinned
+                break;
+            }
+            RetireFrame(tar, lck);
+        }
+        replacer_->SetCapacity(pool_size_);
+        return pool_size_;
+    }
+
+/*
+ * Allocate the data of a retired frame and put it on the free list, with a
+ * pin count of -1 like a deleted page's frame. False if out of memory
+ */
+    bool BufferPoolManager::ActivateFrame(Page *tar) {
+        void *memory = nullptr;
+        if (posix_memalign(&memory, GetBufferAlignment(), page_size_) != 0) {
+            return false;
+        }
+        tar->data_ = static_cast<char *>(memory);
+        tar->ResetMemory();
+        free_list_->push_back(tar);
+        pool_size_++;
+        return true;
+    }
+
+/*
+ * Write the page of a claimed frame back if it is dirty, as an eviction does,
+ * then free the frame's data. The frame is neither in the page table nor in
+ * the replacer, and its pin count of -1 keeps hits off it for good
+ */
+    void BufferPoolManager::RetireFrame(Page *tar, unique_lock<mutex> &lck) {
+        page_id_t old_page_id = tar->page_id_;
+        if (old_page_id != INVALID_PAGE_ID) {
+            counters_.Add(BufferPoolCounter::EVICTIONS);
+        }
+        if (tar->is_dirty_) {
+            tar->is_dirty_ = false;
+            writing_.insert(old_page_id);
+            written_cv_.wait(lck, [&] { return writing_.count(old_page_id) == 1; });
+            lck.unlock();
+            vector<DiskManager::PageWrite> batch{{old_page_id, tar->data_}};
+            disk_manager_->WritePages(batch);
+            counters_.Add(BufferPoolCounter::WRITE_BACKS);
+            lck.lock();
+            writing_.erase(writing_.find(old_page_id));
+            written_cv_.notify_all();
+        }
+        tar->page_id_ = INVALID_PAGE_ID;
+        free(tar->data_);
+        tar->data_ = nullptr;
+        pool_size_--;
+    }
+
+/*
+ * Recycle the ring slot that is up next if its frame belongs to this pool,
+ * still holds the page the ring loaded and is evictable; otherwise take a
+ * victim from the pool. Caller must hold latch_
+ */
+    Page *BufferPoolManager::GetRingVictim(BufferAccessStrategy *strategy) {
+        if (strategy->ring_.empty()) {
+            return GetVictimPage();
+        }
+        Page *tar = strategy->ring_[strategy->next_].first;
+        page_id_t page_id = strategy->ring_[strategy->next_].second;
+        if (tar != nullptr && tar >= pages_ && tar < pages_ + max_pool_size_ &&
+            tar->page_id_ == page_id && tar->pin_count_ == 0 &&
+            replacer_->Evict(tar) && ClaimFrame(tar)) {
+            counters_.Add(BufferPoolCounter::RING_REUSES);
+            return tar;
+        }
+        return GetVictimPage();
+    }
+
 //DEBUG
     bool BufferPoolManager::CheckAllUnpined() {
         bool res = true;
-        for (size_t i = 1; i < pool_size_; i++) {
-            if (pages_[i].pin_count_ != 0) {
+        // pages read ahead hold their frames until the read is done
+        unique_lock<mutex> lck = LockLatch();
+        for (size_t i = 1; i < max_pool_size_; i++) {
+            while (!prefetch_queue_.empty() ||
+                   pages_[i].io_state_ != Page::IOState::NONE) {
+                pages_[i].io_cv_.wait_for(lck, chrono::milliseconds(1));
+            }
+            if (pages_[i].pin_count_ > 0) {
                 res = false;
                 std::cout<<"page "<<pages_[i].page_id_<<" pin count:"<<pages_[i].pin_count_<<std::endl;
             }
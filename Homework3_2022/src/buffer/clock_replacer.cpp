@@ -0,0 +1,108 @@
+/**
+ * CLOCK implementation
+ */
+#include <cassert>
+
+#include "buffer/clock_replacer.h"
+#include "page/page.h"
+
+namespace scudb {
+using namespace std;
+    template <typename T>
+    ClockReplacer<T>::ClockReplacer(T base, size_t num_frames)
+            : base_(base), num_frames_(num_frames),
+              states_(new atomic<uint8_t>[num_frames]), size_(0), hand_(0) {
+        for (size_t i = 0; i < num_frames_; ++i) {
+            states_[i].store(0, memory_order_relaxed);
+        }
+    }
+
+    template <typename T> ClockReplacer<T>::~ClockReplacer() {}
+
+/*
+ * Mark value as evictable and referenced (a frame just got unpinned)
+ */
+    template <typename T> void ClockReplacer<T>::Insert(const T &value) {
+        size_t frame = FrameOf(value);
+        assert(frame < num_frames_);
+        uint8_t old = states_[frame].fetch_or(EVICTABLE | REFERENCED);
+        if (!(old & EVICTABLE)) {
+            size_++;
+        }
+    }
+
+/*
+ * Sweep the hand: a referenced frame gets a second chance (its bit is
+ * cleared), the first evictable unreferenced frame is the victim. Pinned
+ * frames are stepped over as they are. Return false if nothing is evictable,
+ * or if a whole round found only pinned frames.
+ */
+    template <typename T> bool ClockReplacer<T>::Victim(T &value) {
+        lock_guard<mutex> lck(hand_latch_);
+        size_t pinned_run = 0;
+        while (size_.load() > 0 && pinned_run < num_frames_) {
+            size_t frame = hand_;
+            hand_ = (hand_ + 1) % num_frames_;
+            uint8_t state = states_[frame].load();
+            if (!(state & EVICTABLE) || this->IsPinned(base_ + frame)) {
+                pinned_run++;
+                continue;
+            }
+            pinned_run = 0;
+            if (state & REFERENCED) {
+                states_[frame].fetch_and(static_cast<uint8_t>(~REFERENCED));
+                continue;
+            }
+            // an Insert/Erase racing with us makes the exchange fail, in that
+            // case the frame is looked at again on the next round
+            if (states_[frame].compare_exchange_strong(state, 0)) {
+                size_--;
+                value = base_ + frame;
+                return true;
+            }
+        }
+        return false;
+    }
+
+/*
+ * Remove value from the replacer (a frame got pinned). Return true if it was
+ * evictable before this call
+ */
+    template <typename T> bool ClockReplacer<T>::Erase(const T &value) {
+        size_t frame = FrameOf(value);
+        assert(frame < num_frames_);
+        uint8_t old = states_[frame].fetch_and(
+                static_cast<uint8_t>(~(EVICTABLE | REFERENCED)));
+        if (old & EVICTABLE) {
+            size_--;
+            return true;
+        }
+        return false;
+    }
+
+    template <typename T> size_t ClockReplacer<T>::Size() { return size_.load(); }
+
+/*
+ * The frames the hand would take next: unreferenced ones in hand order, then
+ * the referenced ones it would take on its second round
+ */
+    template <typename T>
+    void ClockReplacer<T>::Candidates(vector<T> &out, size_t n) {
+        lock_guard<mutex> lck(hand_latch_);
+        for (uint8_t want : {uint8_t(EVICTABLE), uint8_t(EVICTABLE | REFERENCED)}) {
+            for (size_t i = 0; i < num_frames_ && n > 0; ++i) {
+                size_t frame = (hand_ + i) % num_frames_;
+                if (states_[frame].load() == want &&
+                    !this->IsPinned(base_ + frame)) {
+                    out.push_back(base_ + frame);
+                    n--;
+                }
+            }
+        }
+    }
+
+    template class ClockReplacer<Page *>;
+// test only
+    template class ClockReplacer<int>;
+
+} // namespace scudb
@@ -0,0 +1,175 @@
+/**
+ * LRU-K implementation
+ */
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+
+#include "buffer/lru_k_replacer.h"
+#include "page/page.h"
+
+namespace scudb {
+using namespace std;
+    template <typename T>
+    LRUKReplacer<T>::LRUKReplacer(size_t k, uint64_t correlated_period)
+            : mK(k), mCorrelatedPeriod(correlated_period), mClock(0), mSize(0) {
+        assert(mK > 0);
+    }
+
+    template <typename T> LRUKReplacer<T>::~LRUKReplacer() {}
+
+/*
+ * Record a reference to value and make it evictable
+ */
+    template <typename T> void LRUKReplacer<T>::Insert(const T &value) {
+        Reference(value, false);
+    }
+
+/*
+ * The frame is evictable from the time of the read-ahead on, but that time is
+ * taken back by its first real reference
+ */
+    template <typename T>
+    void LRUKReplacer<T>::InsertPrefetched(const T &value) {
+        Reference(value, true);
+    }
+
+    template <typename T>
+    void LRUKReplacer<T>::Reference(const T &value, bool prefetched) {
+        lock_guard<mutex> lck(mLatch);
+        // a read-ahead is not a reference, it must not break up the
+        // correlated references of other frames either
+        if (!prefetched) {
+            mClock++;
+        }
+        sHistory &history = mHistoryMap[value];
+        if (history.refs.empty()) {
+            history.refs.reserve(mK);
+        }
+        if (!history.refs.empty() && (history.prefetched ||
+            mClock - history.refs.back() <= mCorrelatedPeriod)) {
+            // correlated with the previous reference, or that was only a
+            // read-ahead: move it forward
+            history.refs.back() = mClock;
+        } else {
+            if (history.refs.size() == mK) {
+                history.refs.erase(history.refs.begin());
+            }
+            history.refs.push_back(mClock);
+        }
+        history.prefetched = prefetched;
+        if (!history.evictable) {
+            history.evictable = true;
+            mSize++;
+        }
+    }
+
+/*
+ * Evict the frame with the largest backward K-distance. Frames with fewer than
+ * K references come first, oldest last reference first. Linear in the number
+ * of tracked frames, which is bounded by the pool size.
+ */
+    template <typename T> bool LRUKReplacer<T>::Victim(T &value) {
+        lock_guard<mutex> lck(mLatch);
+        if (mSize == 0) {
+            return false;
+        }
+        auto victim = mHistoryMap.end();
+        bool victim_infinite = false;
+        uint64_t victim_time = 0;
+        for (auto it = mHistoryMap.begin(); it != mHistoryMap.end(); ++it) {
+            if (!it->second.evictable || this->IsPinned(it->first)) {
+                continue;
+            }
+            const vector<uint64_t> &refs = it->second.refs;
+            bool infinite = refs.size() < mK;
+            uint64_t time = infinite ? refs.back() : refs.front();
+            if (victim == mHistoryMap.end() ||
+                (infinite && !victim_infinite) ||
+                (infinite == victim_infinite && time < victim_time)) {
+                victim = it;
+                victim_infinite = infinite;
+                victim_time = time;
+            }
+        }
+        if (victim == mHistoryMap.end()) {
+            return false;
+        }
+        value = victim->first;
+        mHistoryMap.erase(victim);
+        mSize--;
+        return true;
+    }
+
+/*
+ * Make value non-evictable (it got pinned), its history is kept. If removal is
+ * successful, return true, otherwise return false
+ */
+    template <typename T> bool LRUKReplacer<T>::Erase(const T &value) {
+        lock_guard<mutex> lck(mLatch);
+        auto it = mHistoryMap.find(value);
+        if (it == mHistoryMap.end() || !it->second.evictable) {
+            return false;
+        }
+        it->second.evictable = false;
+        mSize--;
+        return true;
+    }
+
+    template <typename T> size_t LRUKReplacer<T>::Size() {
+        lock_guard<mutex> lck(mLatch);
+        return mSize;
+    }
+
+/*
+ * Evictable frames in the order Victim would pick them
+ */
+    template <typename T>
+    void LRUKReplacer<T>::Candidates(vector<T> &out, size_t n) {
+        lock_guard<mutex> lck(mLatch);
+        // (finite K-distance, time) sorts the next victim first
+        vector<tuple<bool, uint64_t, T>> order;
+        for (auto &entry : mHistoryMap) {
+            if (!entry.second.evictable || this->IsPinned(entry.first)) {
+                continue;
+            }
+            const vector<uint64_t> &refs = entry.second.refs;
+            bool infinite = refs.size() < mK;
+            order.emplace_back(!infinite, infinite ? refs.back() : refs.front(),
+                               entry.first);
+        }
+        n = min(n, order.size());
+        partial_sort(order.begin(), order.begin() + n, order.end());
+        for (size_t i = 0; i < n; ++i) {
+            out.push_back(get<2>(order[i]));
+        }
+    }
+
+    template <typename T> bool LRUKReplacer<T>::Evict(const T &value) {
+        lock_guard<mutex> lck(mLatch);
+        auto it = mHistoryMap.find(value);
+        if (it == mHistoryMap.end() || !it->second.evictable) {
+            return false;
+        }
+        mHistoryMap.erase(it);
+        mSize--;
+        return true;
+    }
+
+    template <typename T> void LRUKReplacer<T>::Forget(const T &value) {
+        lock_guard<mutex> lck(mLatch);
+        auto it = mHistoryMap.find(value);
+        if (it == mHistoryMap.end()) {
+            return;
+        }
+        if (it->second.evictable) {
+            mSize--;
+        }
+        mHistoryMap.erase(it);
+    }
+
+    template class LRUKReplacer<Page *>;
+// test only
+    template class LRUKReplacer<int>;
+
+} // namespace scudb
@@ -51,17 +51,20 @@ using namespace  std;
         return;
     }
 
-/* If LRU is non-empty, pop the mHead member from LRU to argument "value", and
- * return true. If LRU is empty, return false
+/* If LRU is non-empty, pop the least recently used member that is not pinned
+ * to argument "value", and return true. If there is none, return false
  */
     template <typename T> bool LRUReplacer<T>::Victim(T &value) {
         lock_guard<mutex> lck(mLatch);
-        if (mDataMap.empty()) {
+        shared_ptr<sNode> last = mTail->ptrPrev;
+        while (last != mHead && this->IsPinned(last->data)) {
+            last = last->ptrPrev;
+        }
+        if (last == mHead) {
             return false;
         }
-        shared_ptr<sNode> last = mTail->ptrPrev;
-        mTail->ptrPrev = last->ptrPrev;
-        last->ptrPrev->ptrNext = mTail;
+        last->ptrPrev->ptrNext = last->ptrNext;
+        last->ptrNext->ptrPrev = last->ptrPrev;
         value = last->data;
         mDataMap.erase(last->data);
         return true;
@@ -83,7 +86,22 @@ using namespace  std;
 
     template <typename T> size_t LRUReplacer<T>::Size() {
         lock_guard<mutex> lck(mLatch);
-        return 1;//mDataMap.size();
+        return mDataMap.size();
+    }
+
+/*
+ * Walk from the LRU end without removing anything
+ */
+    template <typename T>
+    void LRUReplacer<T>::Candidates(vector<T> &out, size_t n) {
+        lock_guard<mutex> lck(mLatch);
+        for (shared_ptr<sNode> cur = mTail->ptrPrev; cur != mHead && n > 0;
+             cur = cur->ptrPrev) {
+            if (!this->IsPinned(cur->data)) {
+                out.push_back(cur->data);
+                n--;
+            }
+        }
     }
 
     template class LRUReplacer<Page *>;
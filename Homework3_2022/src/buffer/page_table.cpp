@@ -0,0 +1,88 @@
+/**
+ * open addressing page table implementation
+ */
+#include <cassert>
+
+#include "buffer/page_table.h"
+
+namespace scudb {
+using namespace std;
+    PageTable::PageTable(size_t num_frames) : bits_(1) {
+        // at most half full
+        while ((size_t(1) << bits_) < 2 * num_frames) {
+            bits_++;
+        }
+        mask_ = (size_t(1) << bits_) - 1;
+        slots_.reset(new atomic<uint64_t>[mask_ + 1]);
+        for (size_t i = 0; i <= mask_; ++i) {
+            slots_[i].store(EMPTY, memory_order_relaxed);
+        }
+    }
+
+/*
+ * Probe from the home slot of page_id up to the first empty slot. At most
+ * half the slots are used, so there always is one
+ */
+    bool PageTable::Find(page_id_t page_id, frame_id_t &frame_id) const {
+        for (size_t i = HomeOf(page_id), n = 0; n <= mask_;
+             i = (i + 1) & mask_, ++n) {
+            uint64_t slot = slots_[i].load(memory_order_acquire);
+            if (slot == EMPTY) {
+                return false;
+            }
+            if (PageOf(slot) == page_id) {
+                frame_id = FrameOf(slot);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+        size_t i = HomeOf(page_id);
+        while (slots_[i].load(memory_order_relaxed) != EMPTY) {
+            assert(PageOf(slots_[i].load(memory_order_relaxed)) != page_id);
+            i = (i + 1) & mask_;
+        }
+        slots_[i].store(Pack(page_id, frame_id), memory_order_release);
+    }
+
+/*
+ * Empty the slot of page_id, then move back every entry of the probe run
+ * after it that would not be found past the hole otherwise (Knuth's
+ * algorithm R). An entry is written to its new slot before its old one is
+ * cleared, so a concurrent Find sees it twice at worst, or misses it if it
+ * already passed the new slot
+ */
+    bool PageTable::Remove(page_id_t page_id) {
+        size_t hole = HomeOf(page_id);
+        while (true) {
+            uint64_t slot = slots_[hole].load(memory_order_relaxed);
+            if (slot == EMPTY) {
+                return false;
+            }
+            if (PageOf(slot) == page_id) {
+                break;
+            }
+            hole = (hole + 1) & mask_;
+        }
+        slots_[hole].store(EMPTY, memory_order_release);
+
+        for (size_t i = (hole + 1) & mask_;; i = (i + 1) & mask_) {
+            uint64_t slot = slots_[i].load(memory_order_relaxed);
+            if (slot == EMPTY) {
+                break;
+            }
+            // the entry stays if its home lies cyclically in (hole, i]
+            size_t home = HomeOf(PageOf(slot));
+            if (((i - home) & mask_) < ((i - hole) & mask_)) {
+                continue;
+            }
+            slots_[hole].store(slot, memory_order_release);
+            slots_[i].store(EMPTY, memory_order_release);
+            hole = i;
+        }
+        return true;
+    }
+
+} // namespace scudb
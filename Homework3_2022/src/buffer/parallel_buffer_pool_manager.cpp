@@ -0,0 +1,252 @@
+#include <algorithm>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+namespace scudb {
+
+    const uint64_t ParallelBufferPoolManager::EMPTY;
+    const uint64_t ParallelBufferPoolManager::TOMBSTONE;
+
+/*
+ * ParallelBufferPoolManager Constructor
+ * Frames are split as evenly as possible, the first pool_size % num_instances
+ * instances get one extra frame
+ */
+    ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances,
+                                                         size_t pool_size,
+                                                         DiskManager *disk_manager,
+                                                         LogManager *log_manager,
+                                                         ReplacerType replacer_type,
+                                                         size_t max_pool_size)
+            : BufferPoolManager(disk_manager, log_manager) {
+        assert(num_instances > 0);
+        pool_size_ = pool_size;
+        max_pool_size_ = std::max(pool_size, max_pool_size);
+        for (size_t i = 0; i < num_instances; ++i) {
+            size_t frames = pool_size / num_instances + (i < pool_size % num_instances);
+            size_t max_frames = max_pool_size_ / num_instances +
+                                (i < max_pool_size_ % num_instances);
+            instances_.push_back(new BufferPoolManager(frames, disk_manager, log_manager,
+                                                       replacer_type, max_frames));
+        }
+        // room for as many placed pages as the pool has frames, at most half
+        // the slots in use
+        size_t slots = 16;
+        while (slots < 2 * max_pool_size_) {
+            slots *= 2;
+        }
+        placed_mask_ = slots - 1;
+        placed_.reset(new std::atomic<uint64_t>[slots]);
+        for (size_t i = 0; i < slots; ++i) {
+            placed_[i].store(EMPTY, std::memory_order_relaxed);
+        }
+    }
+
+    ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+        for (auto instance : instances_) {
+            delete instance;
+        }
+    }
+
+/*
+ * The instance responsible for page_id, page ids are dense so a modulo spreads
+ * them evenly. placed_ is only searched once a page was put elsewhere, without
+ * a lock: probe from the home slot up to the first empty slot, tombstones
+ * never match
+ */
+    BufferPoolManager *ParallelBufferPoolManager::GetInstance(page_id_t page_id) {
+        size_t instance = static_cast<size_t>(page_id) % instances_.size();
+        if (num_placed_.load(std::memory_order_acquire) == 0) {
+            return instances_[instance];
+        }
+        for (size_t i = PlacedHomeOf(page_id), n = 0; n <= placed_mask_;
+             i = (i + 1) & placed_mask_, ++n) {
+            uint64_t slot = placed_[i].load(std::memory_order_acquire);
+            if (slot == EMPTY) {
+                break;
+            }
+            if (static_cast<page_id_t>(slot >> 32) == page_id) {
+                instance = static_cast<size_t>(slot & 0xFFFFFFFF);
+                break;
+            }
+        }
+        return instances_[instance];
+    }
+
+/*
+ * Record that page_id lives on instance. False if placed_ has no room left;
+ * slots of removed entries are only reused once the table is empty again
+ */
+    bool ParallelBufferPoolManager::Place(page_id_t page_id, size_t instance) {
+        std::lock_guard<std::mutex> guard(placed_latch_);
+        if (placed_used_ >= (placed_mask_ + 1) / 2) {
+            return false;
+        }
+        size_t i = PlacedHomeOf(page_id);
+        while (placed_[i].load(std::memory_order_relaxed) != EMPTY) {
+            i = (i + 1) & placed_mask_;
+        }
+        placed_[i].store((static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) |
+                         static_cast<uint32_t>(instance),
+                         std::memory_order_release);
+        placed_used_++;
+        num_placed_++;
+        return true;
+    }
+
+/*
+ * Forget where the pages matching in_placed live, they are back on their own
+ * instance. The table is cleared once no entry is left, no lookup can miss
+ * anything then
+ */
+    template <typename Predicate>
+    void ParallelBufferPoolManager::Unplace(Predicate in_placed) {
+        if (num_placed_ == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> guard(placed_latch_);
+        for (size_t i = 0; i <= placed_mask_; ++i) {
+            uint64_t slot = placed_[i].load(std::memory_order_relaxed);
+            if (slot != EMPTY && slot != TOMBSTONE &&
+                in_placed(static_cast<page_id_t>(slot >> 32))) {
+                placed_[i].store(TOMBSTONE, std::memory_order_release);
+                num_placed_--;
+            }
+        }
+        if (num_placed_ == 0) {
+            for (size_t i = 0; i <= placed_mask_; ++i) {
+                placed_[i].store(EMPTY, std::memory_order_release);
+            }
+            placed_used_ = 0;
+        }
+    }
+
+    Page *ParallelBufferPoolManager::FetchPage(page_id_t page_id,
+                                               BufferAccessStrategy *strategy) {
+        return GetInstance(page_id)->FetchPage(page_id, strategy);
+    }
+
+    bool ParallelBufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+        return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+    }
+
+    bool ParallelBufferPoolManager::FlushPage(page_id_t page_id) {
+        return GetInstance(page_id)->FlushPage(page_id);
+    }
+
+    void ParallelBufferPoolManager::FlushAllPages() {
+        for (auto instance : instances_) {
+            instance->FlushAllPages();
+        }
+    }
+
+    bool ParallelBufferPoolManager::DeletePage(page_id_t page_id) {
+        if (!GetInstance(page_id)->DeletePage(page_id)) {
+            return false;
+        }
+        Unplace([page_id](page_id_t placed) { return placed == page_id; });
+        return true;
+    }
+
+    bool ParallelBufferPoolManager::DropFile(int file_id) {
+        bool ok = true;
+        for (auto instance : instances_) {
+            ok = instance->DiscardFile(file_id) && ok;
+        }
+        if (ok) {
+            Unplace([file_id](page_id_t placed) {
+                return DiskManager::GetFileId(placed) == file_id;
+            });
+        }
+        return ok && disk_manager_->DropFile(file_id);
+    }
+
+/*
+ * Page ids come from the disk manager's counter (or the caller's extent), so
+ * consecutive new pages already land on consecutive instances. Exactly one
+ * id is allocated: it goes to its own instance, or, if that one has every
+ * frame pinned, to the next instance round-robin that has a frame, which is
+ * recorded in placed_ first. The id is handed back to the disk manager only
+ * if no instance had a free frame (or placed_ is full); return nullptr then,
+ * or if the disk manager had no page id.
+ */
+    Page *ParallelBufferPoolManager::NewPage(page_id_t &page_id,
+                                             PageExtent *extent) {
+        page_id_t candidate = disk_manager_->AllocatePage(extent);
+        if (candidate == INVALID_PAGE_ID) {
+            return nullptr;
+        }
+        size_t n = instances_.size();
+        size_t owner = static_cast<size_t>(candidate) % n;
+        size_t instance = owner;
+        Page *tar = instances_[owner]->NewPageWithId(candidate);
+        size_t start = next_instance_++;
+        for (size_t i = 0; tar == nullptr && i < n; ++i) {
+            instance = (start + i) % n;
+            if (instance == owner) {
+                continue;
+            }
+            if (!Place(candidate, instance)) {
+                break;
+            }
+            tar = instances_[instance]->NewPageWithId(candidate);
+            if (tar == nullptr) {
+                Unplace([candidate](page_id_t placed) { return placed == candidate; });
+            }
+        }
+        if (tar == nullptr) {
+            disk_manager_->DeallocatePage(candidate);
+            return nullptr;
+        }
+        page_id = candidate;
+        return tar;
+    }
+
+    BufferPoolStats ParallelBufferPoolManager::GetStats() {
+        BufferPoolStats stats;
+        for (auto instance : instances_) {
+            stats += instance->GetStats();
+        }
+        return stats;
+    }
+
+    void ParallelBufferPoolManager::RunCleanerThread(size_t clean_frames) {
+        size_t n = instances_.size();
+        for (size_t i = 0; i < n; ++i) {
+            size_t frames = clean_frames / n + (i < clean_frames % n);
+            instances_[i]->RunCleanerThread(std::max<size_t>(frames, 1));
+        }
+    }
+
+    void ParallelBufferPoolManager::StopCleanerThread() {
+        for (auto instance : instances_) {
+            instance->StopCleanerThread();
+        }
+    }
+
+    void ParallelBufferPoolManager::Prefetch(page_id_t first, size_t n) {
+        for (page_id_t page_id = first; page_id < first + (page_id_t)n; ++page_id) {
+            GetInstance(page_id)->Prefetch(page_id, 1);
+        }
+    }
+
+    size_t ParallelBufferPoolManager::Resize(size_t pool_size) {
+        size_t n = instances_.size();
+        size_t total = 0;
+        for (size_t i = 0; i < n; ++i) {
+            total += instances_[i]->Resize(pool_size / n + (i < pool_size % n));
+        }
+        pool_size_ = total;
+        return total;
+    }
+
+//DEBUG
+    bool ParallelBufferPoolManager::CheckAllUnpined() {
+        bool res = true;
+        for (auto instance : instances_) {
+            res = instance->CheckAllUnpined() && res;
+        }
+        return res;
+    }
+
+} // namespace scudb
@@ -0,0 +1,57 @@
+/**
+ * read-ahead implementation
+ */
+#include <algorithm>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/read_ahead.h"
+
+namespace scudb {
+using namespace std;
+    // pages prefetched on the first sequential step
+    static const size_t MIN_WINDOW = 4;
+
+/*
+ * The window is capped at a quarter of the pool, so read-ahead cannot push
+ * out more than that of what other users have cached
+ */
+    ReadAhead::ReadAhead(BufferPoolManager *buffer_pool_manager,
+                         BufferAccessStrategy *strategy)
+            : buffer_pool_manager_(buffer_pool_manager),
+              last_page_id_(INVALID_PAGE_ID), prefetched_end_(INVALID_PAGE_ID),
+              window_(0),
+              max_window_(max<size_t>(buffer_pool_manager->GetPoolSize() / 4, 1)) {
+        if (strategy != nullptr && strategy->GetRingSize() > 0) {
+            max_window_ = 0;
+        }
+    }
+
+    void ReadAhead::Access(page_id_t page_id) {
+        if (max_window_ == 0) {
+            return;
+        }
+        bool sequential = last_page_id_ != INVALID_PAGE_ID &&
+                          page_id == last_page_id_ + 1;
+        last_page_id_ = page_id;
+        if (!sequential) {
+            window_ = 0;
+            prefetched_end_ = page_id + 1;
+            return;
+        }
+        if (window_ == 0) {
+            window_ = min(MIN_WINDOW, max_window_);
+        } else if (page_id + static_cast<page_id_t>(window_ / 2) < prefetched_end_) {
+            // still well inside the prefetched range
+            return;
+        } else {
+            window_ = min(window_ * 2, max_window_);
+        }
+        page_id_t first = max(prefetched_end_, page_id + 1);
+        page_id_t end = page_id + 1 + static_cast<page_id_t>(window_);
+        if (first < end) {
+            buffer_pool_manager_->Prefetch(first, end - first);
+            prefetched_end_ = end;
+        }
+    }
+
+} // namespace scudb
@@ -4,4 +4,6 @@ namespace scudb {
   std::atomic<bool> ENABLE_LOGGING(false);  // for virtual table
   std::chrono::duration<long long int> LOG_TIMEOUT =
    std::chrono::seconds(1);
+  // how often an idle page cleaner looks at the buffer pool
+  std::chrono::milliseconds CLEANER_TIMEOUT = std::chrono::milliseconds(10);
 }
@@ -0,0 +1,450 @@
+/**
+ * async_io.cpp
+ */
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define SCUDB_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "common/logger.h"
+#include "disk/async_io.h"
+
+namespace scudb {
+
+static inline void CountSyscall(std::atomic<uint64_t> *syscalls) {
+  if (syscalls != nullptr) {
+    (*syscalls)++;
+  }
+}
+
+ssize_t PReadAll(int fd, char *data, size_t size, off_t offset,
+                 std::atomic<uint64_t> *syscalls) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = pread(fd, data + done, size - done, offset + done);
+    CountSyscall(syscalls);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && done > 0 && errno == EINVAL) {
+      // O_DIRECT: a short read ended at the end of the file, the rest would
+      // start at an unaligned offset
+      break;
+    }
+    if (n < 0) {
+      return -errno;
+    }
+    if (n == 0) {
+      break;
+    }
+    done += n;
+  }
+  return done;
+}
+
+ssize_t PWriteAll(int fd, const char *data, size_t size, off_t offset,
+                  std::atomic<uint64_t> *syscalls) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = pwrite(fd, data + done, size - done, offset + done);
+    CountSyscall(syscalls);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return -errno;
+    }
+    if (n == 0) {
+      return -EIO;
+    }
+    done += n;
+  }
+  return done;
+}
+
+ssize_t PWriteVAll(int fd, const struct iovec *iov, int iovcnt, off_t offset,
+                   std::atomic<uint64_t> *syscalls) {
+  std::vector<struct iovec> rest(iov, iov + iovcnt);
+  size_t first = 0; // rest[first] is the buffer being written
+  size_t done = 0;
+  while (first < rest.size()) {
+    int count = static_cast<int>(std::min<size_t>(rest.size() - first, IOV_MAX));
+    ssize_t n = pwritev(fd, &rest[first], count, offset + done);
+    CountSyscall(syscalls);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return -errno;
+    }
+    if (n == 0) {
+      return -EIO;
+    }
+    done += n;
+    // drop the buffers written, trim a partly written one
+    for (size_t left = n; left > 0 && first < rest.size();) {
+      if (left >= rest[first].iov_len) {
+        left -= rest[first++].iov_len;
+      } else {
+        rest[first].iov_base = static_cast<char *>(rest[first].iov_base) + left;
+        rest[first].iov_len -= left;
+        left = 0;
+      }
+    }
+    while (first < rest.size() && rest[first].iov_len == 0) {
+      first++;
+    }
+  }
+  return done;
+}
+
+IOCompletion AsyncIO::Submit(std::unique_ptr<IORequest> request) {
+  IOCompletion completion = request->done.get_future();
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    queue_.push_back(std::move(request));
+  }
+  cv_.notify_one();
+  return completion;
+}
+
+std::vector<std::unique_ptr<IORequest>> AsyncIO::TakeRequests(size_t max,
+                                                             bool block) {
+  std::vector<std::unique_ptr<IORequest>> requests;
+  std::unique_lock<std::mutex> lck(latch_);
+  if (block) {
+    cv_.wait(lck, [&] { return stop_ || !queue_.empty(); });
+  }
+  while (!queue_.empty() && requests.size() < max) {
+    requests.push_back(std::move(queue_.front()));
+    queue_.pop_front();
+  }
+  return requests;
+}
+
+void AsyncIO::Shutdown() {
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+}
+
+void AsyncIO::Complete(std::unique_ptr<IORequest> request, ssize_t result) {
+  request->done.set_value(request->on_done ? request->on_done(result)
+                                           : result == (ssize_t)request->size);
+}
+
+/*
+ * Do the rest of a request after done bytes went through (all of it when done
+ * is 0); a read may stop early at the end of the file
+ */
+ssize_t AsyncIO::Transfer(IORequest &request, size_t done) {
+  ssize_t rest;
+  if (!request.is_write) {
+    rest = PReadAll(request.fd, request.data + done, request.size - done,
+                    request.offset + done, &num_syscalls_);
+  } else if (request.iov.empty()) {
+    rest = PWriteAll(request.fd, request.data + done, request.size - done,
+                     request.offset + done, &num_syscalls_);
+  } else {
+    // skip the buffers already written
+    std::vector<struct iovec> iov;
+    size_t skip = done;
+    for (const struct iovec &buffer : request.iov) {
+      if (skip >= buffer.iov_len) {
+        skip -= buffer.iov_len;
+        continue;
+      }
+      iov.push_back({static_cast<char *>(buffer.iov_base) + skip,
+                     buffer.iov_len - skip});
+      skip = 0;
+    }
+    rest = PWriteVAll(request.fd, iov.data(), static_cast<int>(iov.size()),
+                      request.offset + done, &num_syscalls_);
+  }
+  return rest < 0 ? rest : static_cast<ssize_t>(done) + rest;
+}
+
+/*
+ * Worker threads that each take one request at a time and do it with
+ * pread/pwrite, so up to NUM_THREADS transfers are in flight
+ */
+class ThreadPoolIO : public AsyncIO {
+public:
+  static const int NUM_THREADS = 4;
+
+  ThreadPoolIO() {
+    for (int i = 0; i < NUM_THREADS; i++) {
+      workers_.emplace_back(&ThreadPoolIO::WorkerLoop, this);
+    }
+  }
+
+  ~ThreadPoolIO() {
+    Shutdown();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  AsyncIOType GetType() const { return AsyncIOType::THREAD_POOL; }
+
+private:
+  void WorkerLoop() {
+    while (true) {
+      auto requests = TakeRequests(1, true);
+      if (requests.empty()) {
+        return;
+      }
+      ssize_t result = Transfer(*requests[0], 0);
+      Complete(std::move(requests[0]), result);
+    }
+  }
+
+  std::vector<std::thread> workers_;
+};
+
+#ifdef SCUDB_HAVE_IO_URING
+/*
+ * One io_uring, set up and mapped by hand. A single thread owns both queues:
+ * it fills submission entries for everything queued (as far as the ring has
+ * room), submits them and waits for completions with one io_uring_enter, and
+ * completes the requests whose completion entries came back. Requests queued
+ * while it waits go out with the next batch. If io_uring_enter fails with
+ * anything but a transient error, the requests it did not submit are done on
+ * this thread with pread/pwrite, so none is left waiting.
+ */
+class UringIO : public AsyncIO {
+public:
+  static const unsigned ENTRIES = 64;
+
+  UringIO() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = syscall(__NR_io_uring_setup, ENTRIES, &params);
+    if (ring_fd_ < 0) {
+      return;
+    }
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+      sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+    sq_ring_ = Map(sq_size_, IORING_OFF_SQ_RING);
+    cq_ring_ = single_mmap ? sq_ring_ : Map(cq_size_, IORING_OFF_CQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = static_cast<struct io_uring_sqe *>(
+        Map(sqes_size_, IORING_OFF_SQES));
+    if (sq_ring_ == nullptr || cq_ring_ == nullptr || sqes_ == nullptr) {
+      Unmap();
+      return;
+    }
+    char *sq = static_cast<char *>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    char *cq = static_cast<char *>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    thread_ = std::thread(&UringIO::RingLoop, this);
+  }
+
+  ~UringIO() {
+    if (thread_.joinable()) {
+      Shutdown();
+      thread_.join();
+    }
+    Unmap();
+  }
+
+  bool IsValid() const { return thread_.joinable(); }
+
+  AsyncIOType GetType() const { return AsyncIOType::IO_URING; }
+
+private:
+  // a request in the ring, the kernel reads iov until it completes
+  struct InFlight {
+    std::unique_ptr<IORequest> request;
+    struct iovec iov;
+  };
+
+  void *Map(size_t size, off_t offset) {
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+  }
+
+  void Unmap() {
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_size_);
+    }
+    if (sq_ring_ != nullptr) {
+      munmap(sq_ring_, sq_size_);
+    }
+    sqes_ = nullptr;
+    sq_ring_ = cq_ring_ = nullptr;
+    if (ring_fd_ >= 0) {
+      close(ring_fd_);
+      ring_fd_ = -1;
+    }
+  }
+
+  void RingLoop() {
+    unsigned in_flight = 0;  // submitted, not completed
+    unsigned unsubmitted = 0; // in the submission queue, not taken yet
+    while (true) {
+      // only block for new requests when nothing is outstanding
+      auto requests = TakeRequests(sq_entries_ - in_flight - unsubmitted,
+                                   in_flight + unsubmitted == 0);
+      if (requests.empty() && in_flight + unsubmitted == 0) {
+        return;
+      }
+      unsigned tail = *sq_tail_;
+      for (auto &request : requests) {
+        InFlight *entry = new InFlight();
+        entry->iov.iov_base = request->data;
+        entry->iov.iov_len = request->size;
+        unsigned index = tail & sq_mask_;
+        struct io_uring_sqe *sqe = &sqes_[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = request->is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe->fd = request->fd;
+        if (request->iov.empty()) {
+          sqe->addr = reinterpret_cast<uint64_t>(&entry->iov);
+          sqe->len = 1;
+        } else {
+          sqe->addr = reinterpret_cast<uint64_t>(request->iov.data());
+          sqe->len = request->iov.size();
+        }
+        sqe->off = request->offset;
+        sqe->user_data = reinterpret_cast<uint64_t>(entry);
+        entry->request = std::move(request);
+        sq_array_[index] = index;
+        tail++;
+      }
+      // the entries must be visible before the kernel sees the new tail
+      __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+      unsubmitted += requests.size();
+
+      int ret = syscall(__NR_io_uring_enter, ring_fd_, unsubmitted,
+                        in_flight + unsubmitted > 0 ? 1 : 0,
+                        IORING_ENTER_GETEVENTS, nullptr, 0);
+      num_syscalls_++;
+      if (ret >= 0) {
+        unsubmitted -= ret;
+        in_flight += ret;
+      } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+        tail = TakeBack(unsubmitted, tail);
+        unsubmitted = 0;
+      }
+      in_flight -= Reap();
+    }
+  }
+
+  // the kernel took none of the last count entries before tail and will not,
+  // remove them from the submission queue and do their requests right here;
+  // return the new tail
+  unsigned TakeBack(unsigned count, unsigned tail) {
+    tail -= count;
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+    for (unsigned i = 0; i < count; i++) {
+      struct io_uring_sqe *sqe = &sqes_[(tail + i) & sq_mask_];
+      InFlight *entry = reinterpret_cast<InFlight *>(sqe->user_data);
+      ssize_t result = Transfer(*entry->request, 0);
+      Complete(std::move(entry->request), result);
+      delete entry;
+    }
+    return tail;
+  }
+
+  // complete the requests in the completion queue, return how many
+  unsigned Reap() {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    unsigned count = 0;
+    for (; head != tail; head++, count++) {
+      struct io_uring_cqe *cqe = &cqes_[head & cq_mask_];
+      InFlight *entry = reinterpret_cast<InFlight *>(cqe->user_data);
+      ssize_t result = cqe->res;
+      IORequest &request = *entry->request;
+      if (result > 0 && (size_t)result < request.size) {
+        // a short transfer, finish it in place (a read may just have hit the
+        // end of the file)
+        ssize_t rest = Transfer(request, result);
+        if (rest == -EINVAL && !request.is_write) {
+          // O_DIRECT read that ended at the end of the file
+          rest = result;
+        }
+        result = rest;
+      }
+      Complete(std::move(entry->request), result);
+      delete entry;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return count;
+  }
+
+  int ring_fd_ = -1;
+  void *sq_ring_ = nullptr;
+  void *cq_ring_ = nullptr;
+  struct io_uring_sqe *sqes_ = nullptr;
+  size_t sq_size_ = 0;
+  size_t cq_size_ = 0;
+  size_t sqes_size_ = 0;
+  unsigned *sq_tail_ = nullptr;
+  unsigned *sq_array_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned sq_entries_ = 0;
+  unsigned *cq_head_ = nullptr;
+  unsigned *cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  struct io_uring_cqe *cqes_ = nullptr;
+  std::thread thread_;
+};
+#endif
+
+std::unique_ptr<AsyncIO> AsyncIO::Create() {
+  std::unique_ptr<AsyncIO> async_io = Create(AsyncIOType::IO_URING);
+  if (async_io == nullptr) {
+    LOG_DEBUG("io_uring not available, doing asynchronous I/O on threads");
+    async_io = Create(AsyncIOType::THREAD_POOL);
+  }
+  return async_io;
+}
+
+std::unique_ptr<AsyncIO> AsyncIO::Create(AsyncIOType type) {
+  switch (type) {
+  case AsyncIOType::IO_URING: {
+#ifdef SCUDB_HAVE_IO_URING
+    std::unique_ptr<UringIO> uring(new UringIO());
+    if (uring->IsValid()) {
+      return std::unique_ptr<AsyncIO>(uring.release());
+    }
+#endif
+    return nullptr;
+  }
+  case AsyncIOType::THREAD_POOL:
+  default:
+    return std::unique_ptr<AsyncIO>(new ThreadPoolIO());
+  }
+}
+
+} // namespace scudb
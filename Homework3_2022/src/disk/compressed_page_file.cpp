@@ -0,0 +1,234 @@
+/**
+ * compressed_page_file.cpp
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common/logger.h"
+#include "disk/async_io.h"
+#include "disk/compressed_page_file.h"
+#include "disk/page_compression.h"
+
+namespace scudb {
+
+// the map file starts with magic | page size | slot size | 0, then has a
+// Slot for every page id
+static const uint32_t MAP_MAGIC = 0x504d4353;
+static const off_t MAP_HEADER_SIZE = 16;
+
+const size_t CompressedPageFile::SLOT_SIZE;
+
+CompressedPageFile::CompressedPageFile(int db_fd, const std::string &map_file,
+                                       size_t page_size,
+                                       std::atomic<uint64_t> *syscalls)
+    : db_fd_(db_fd), map_fd_(-1), page_size_(page_size), syscalls_(syscalls),
+      end_unit_(0) {
+  map_fd_ = open(map_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (map_fd_ < 0) {
+    LOG_DEBUG("can't open map file");
+    return;
+  }
+  LoadMap();
+}
+
+CompressedPageFile::~CompressedPageFile() {
+  if (map_fd_ >= 0) {
+    close(map_fd_);
+  }
+}
+
+/*
+ * Read the map, or start a new one in an empty file, and collect the space
+ * the slots leave free
+ */
+void CompressedPageFile::LoadMap() {
+  struct stat stat_buf;
+  if (fstat(map_fd_, &stat_buf) != 0) {
+    stat_buf.st_size = 0;
+  }
+  uint32_t header[4];
+  if (stat_buf.st_size == 0) {
+    header[0] = MAP_MAGIC;
+    header[1] = static_cast<uint32_t>(page_size_);
+    header[2] = static_cast<uint32_t>(SLOT_SIZE);
+    header[3] = 0;
+    if (PWriteAll(map_fd_, reinterpret_cast<char *>(header), MAP_HEADER_SIZE,
+                  0, syscalls_) < 0) {
+      LOG_DEBUG("I/O error while writing");
+    }
+  } else {
+    if (PReadAll(map_fd_, reinterpret_cast<char *>(header), MAP_HEADER_SIZE, 0,
+                 syscalls_) != MAP_HEADER_SIZE ||
+        header[0] != MAP_MAGIC || header[2] != SLOT_SIZE) {
+      LOG_DEBUG("not a page map");
+      close(map_fd_);
+      map_fd_ = -1;
+      return;
+    }
+    page_size_ = header[1];
+    map_.resize((stat_buf.st_size - MAP_HEADER_SIZE) / sizeof(Slot));
+    ssize_t size = map_.size() * sizeof(Slot);
+    if (PReadAll(map_fd_, reinterpret_cast<char *>(map_.data()), size,
+                 MAP_HEADER_SIZE, syscalls_) != size) {
+      LOG_DEBUG("I/O error while reading");
+      map_.clear();
+    }
+  }
+  free_slots_.resize(Units(page_size_) + 1);
+
+  std::vector<std::pair<uint32_t, uint32_t>> used;
+  for (auto &slot : map_) {
+    if (slot.length > page_size_) {
+      LOG_DEBUG("bad map entry, page dropped");
+      slot.length = 0;
+    }
+    if (slot.length != 0) {
+      used.emplace_back(slot.unit, slot.unit + Units(slot.length));
+    }
+  }
+  std::sort(used.begin(), used.end());
+  for (auto &range : used) {
+    if (range.first > end_unit_) {
+      FreeSpace(end_unit_, range.first - end_unit_);
+    }
+    end_unit_ = std::max(end_unit_, range.second);
+  }
+}
+
+/*
+ * A free slot of exactly units if there is one, else the front of the
+ * smallest larger one, else new space at the end of the file
+ */
+uint32_t CompressedPageFile::AllocateSlot(uint32_t units) {
+  for (uint32_t size = units; size < free_slots_.size(); size++) {
+    if (!free_slots_[size].empty()) {
+      uint32_t unit = free_slots_[size].back();
+      free_slots_[size].pop_back();
+      if (size > units) {
+        free_slots_[size - units].push_back(unit + units);
+      }
+      return unit;
+    }
+  }
+  uint32_t unit = end_unit_;
+  end_unit_ += units;
+  return unit;
+}
+
+/*
+ * Make units from unit on free, in slots of at most a full page
+ */
+void CompressedPageFile::FreeSpace(uint32_t unit, uint32_t units) {
+  uint32_t max_units = static_cast<uint32_t>(free_slots_.size() - 1);
+  while (units > 0) {
+    uint32_t size = std::min(units, max_units);
+    free_slots_[size].push_back(unit);
+    unit += size;
+    units -= size;
+  }
+}
+
+ssize_t CompressedPageFile::ReadPage(page_id_t page_id, char *page_data) {
+  Slot slot = {0, 0};
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    if (page_id >= 0 && static_cast<size_t>(page_id) < map_.size()) {
+      slot = map_[page_id];
+    }
+  }
+  if (slot.length == 0) {
+    memset(page_data, 0, page_size_);
+    return 0;
+  }
+  off_t offset = static_cast<off_t>(slot.unit) * SLOT_SIZE;
+  if (slot.length == page_size_) {
+    return PReadAll(db_fd_, page_data, page_size_, offset, syscalls_);
+  }
+  static thread_local std::vector<char> buffer;
+  buffer.resize(page_size_);
+  ssize_t read_count =
+      PReadAll(db_fd_, buffer.data(), slot.length, offset, syscalls_);
+  if (read_count < 0) {
+    return read_count;
+  }
+  if (read_count != static_cast<ssize_t>(slot.length) ||
+      !DecompressBlock(buffer.data(), slot.length, page_data, page_size_)) {
+    LOG_DEBUG("page %d does not decompress", page_id);
+    memset(page_data, 0, page_size_);
+    return -EIO;
+  }
+  return page_size_;
+}
+
+/*
+ * The page goes compressed into its slot (a new one if the size changed),
+ * then its map entry is written to point there, then an old slot is freed
+ */
+bool CompressedPageFile::WritePage(page_id_t page_id, const char *page_data) {
+  if (page_id < 0) {
+    return false;
+  }
+  static thread_local std::vector<char> buffer;
+  buffer.resize(page_size_);
+  const char *data = buffer.data();
+  size_t length =
+      CompressBlock(page_data, page_size_, buffer.data(), page_size_ - 1);
+  if (length == 0) {
+    data = page_data;
+    length = page_size_;
+  }
+  Slot old_slot, slot;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    if (static_cast<size_t>(page_id) >= map_.size()) {
+      map_.resize(page_id + 1, Slot{0, 0});
+    }
+    old_slot = map_[page_id];
+    slot.length = static_cast<uint32_t>(length);
+    slot.unit = old_slot.length != 0 && Units(old_slot.length) == Units(length)
+                    ? old_slot.unit
+                    : AllocateSlot(Units(length));
+    map_[page_id] = slot;
+  }
+  off_t map_offset = MAP_HEADER_SIZE + page_id * sizeof(Slot);
+  bool ok = PWriteAll(db_fd_, data, length,
+                      static_cast<off_t>(slot.unit) * SLOT_SIZE,
+                      syscalls_) >= 0 &&
+            PWriteAll(map_fd_, reinterpret_cast<char *>(&slot), sizeof(Slot),
+                      map_offset, syscalls_) >= 0;
+  if (!ok) {
+    LOG_DEBUG("I/O error while writing");
+  }
+  if (old_slot.length != 0 && old_slot.unit != slot.unit) {
+    std::lock_guard<std::mutex> guard(latch_);
+    FreeSpace(old_slot.unit, Units(old_slot.length));
+  }
+  return ok;
+}
+
+bool CompressedPageFile::Sync() {
+  if (syscalls_ != nullptr) {
+    *syscalls_ += 2;
+  }
+  if (fdatasync(db_fd_) != 0 || fdatasync(map_fd_) != 0) {
+    LOG_DEBUG("fdatasync failed: %s", strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+page_id_t CompressedPageFile::GetNumPages() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return static_cast<page_id_t>(map_.size());
+}
+
+int64_t CompressedPageFile::GetDataSize() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return static_cast<int64_t>(end_unit_) * SLOT_SIZE;
+}
+
+} // namespace scudb
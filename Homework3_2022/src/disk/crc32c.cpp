@@ -0,0 +1,215 @@
+/**
+ * crc32c.cpp
+ */
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+#include "disk/crc32c.h"
+
+namespace scudb {
+
+// the Castagnoli polynomial, bit reversed
+static const uint32_t POLY = 0x82f63b78;
+
+// the hardware path takes three parts of LONG_BLOCK bytes at a time while
+// there are that many, then of SHORT_BLOCK bytes (powers of two)
+static const size_t LONG_BLOCK = 512;
+static const size_t SHORT_BLOCK = 64;
+
+/*
+ * Multiply the 32x32 bit matrix mat with vec, over GF(2)
+ */
+static uint32_t MatrixTimes(const uint32_t *mat, uint32_t vec) {
+  uint32_t sum = 0;
+  while (vec != 0) {
+    if (vec & 1) {
+      sum ^= *mat;
+    }
+    vec >>= 1;
+    mat++;
+  }
+  return sum;
+}
+
+static void MatrixSquare(uint32_t *square, const uint32_t *mat) {
+  for (int n = 0; n < 32; n++) {
+    square[n] = MatrixTimes(mat, mat[n]);
+  }
+}
+
+/*
+ * The operator (a matrix) that moves a CRC register over len zero bytes,
+ * len a power of two: the one for a zero bit, squared up to len bytes
+ */
+static void ZerosOperator(uint32_t *even, size_t len) {
+  uint32_t odd[32];
+  odd[0] = POLY;
+  uint32_t row = 1;
+  for (int n = 1; n < 32; n++) {
+    odd[n] = row;
+    row <<= 1;
+  }
+  // two zero bits in even, four in odd, then a byte in even and so on
+  MatrixSquare(even, odd);
+  MatrixSquare(odd, even);
+  do {
+    MatrixSquare(even, odd);
+    len >>= 1;
+    if (len == 0) {
+      return;
+    }
+    MatrixSquare(odd, even);
+    len >>= 1;
+  } while (len != 0);
+  memcpy(even, odd, sizeof(odd));
+}
+
+namespace {
+struct Tables {
+  // slice[k][n]: the register for byte n followed by k zero bytes
+  uint32_t slice[8][256];
+  // the register moved over LONG_BLOCK or SHORT_BLOCK zero bytes, by byte
+  uint32_t long_shift[4][256];
+  uint32_t short_shift[4][256];
+
+  Tables() {
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t crc = n;
+      for (int k = 0; k < 8; k++) {
+        crc = crc & 1 ? (crc >> 1) ^ POLY : crc >> 1;
+      }
+      slice[0][n] = crc;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+      for (int k = 1; k < 8; k++) {
+        uint32_t crc = slice[k - 1][n];
+        slice[k][n] = (crc >> 8) ^ slice[0][crc & 0xff];
+      }
+    }
+    FillShift(long_shift, LONG_BLOCK);
+    FillShift(short_shift, SHORT_BLOCK);
+  }
+
+  static void FillShift(uint32_t shift[4][256], size_t len) {
+    uint32_t op[32];
+    ZerosOperator(op, len);
+    for (uint32_t n = 0; n < 256; n++) {
+      for (int k = 0; k < 4; k++) {
+        shift[k][n] = MatrixTimes(op, n << (8 * k));
+      }
+    }
+  }
+};
+} // namespace
+
+static const Tables &GetTables() {
+  static const Tables tables;
+  return tables;
+}
+
+static inline uint64_t Load64(const unsigned char *p) {
+  uint64_t word;
+  memcpy(&word, p, 8);
+  return word;
+}
+
+uint32_t Crc32cSoftware(const char *data, size_t size, uint32_t crc) {
+  const Tables &t = GetTables();
+  auto next = reinterpret_cast<const unsigned char *>(data);
+  crc = ~crc;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  while (size > 0 && reinterpret_cast<uintptr_t>(next) % 8 != 0) {
+    crc = t.slice[0][(crc ^ *next++) & 0xff] ^ (crc >> 8);
+    size--;
+  }
+  // the register goes into the low four bytes, each byte is moved over the
+  // ones that follow it in the word
+  for (; size >= 8; size -= 8, next += 8) {
+    uint64_t word = Load64(next) ^ crc;
+    crc = t.slice[7][word & 0xff] ^ t.slice[6][(word >> 8) & 0xff] ^
+          t.slice[5][(word >> 16) & 0xff] ^ t.slice[4][(word >> 24) & 0xff] ^
+          t.slice[3][(word >> 32) & 0xff] ^ t.slice[2][(word >> 40) & 0xff] ^
+          t.slice[1][(word >> 48) & 0xff] ^ t.slice[0][word >> 56];
+  }
+#endif
+  for (; size > 0; size--) {
+    crc = t.slice[0][(crc ^ *next++) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+#if defined(__x86_64__)
+static inline uint32_t Shift(const uint32_t shift[4][256], uint32_t crc) {
+  return shift[0][crc & 0xff] ^ shift[1][(crc >> 8) & 0xff] ^
+         shift[2][(crc >> 16) & 0xff] ^ shift[3][crc >> 24];
+}
+
+/*
+ * While at least three blocks are left, run three CRCs over them side by
+ * side (one from zero for the second and third block each), then combine:
+ * the first moved over a block of zeros, xor the second, and again for the
+ * third
+ */
+__attribute__((target("sse4.2"))) static inline uint64_t
+Crc32cBlocks(uint64_t crc0, const unsigned char *&next, size_t &size,
+             size_t block, const uint32_t shift[4][256]) {
+  while (size >= 3 * block) {
+    uint64_t crc1 = 0, crc2 = 0;
+    const unsigned char *end = next + block;
+    do {
+      crc0 = _mm_crc32_u64(crc0, Load64(next));
+      crc1 = _mm_crc32_u64(crc1, Load64(next + block));
+      crc2 = _mm_crc32_u64(crc2, Load64(next + 2 * block));
+      next += 8;
+    } while (next < end);
+    crc0 = Shift(shift, static_cast<uint32_t>(crc0)) ^ crc1;
+    crc0 = Shift(shift, static_cast<uint32_t>(crc0)) ^ crc2;
+    next += 2 * block;
+    size -= 3 * block;
+  }
+  return crc0;
+}
+
+__attribute__((target("sse4.2"))) static uint32_t
+Crc32cHardware(const char *data, size_t size, uint32_t crc) {
+  const Tables &t = GetTables();
+  auto next = reinterpret_cast<const unsigned char *>(data);
+  uint64_t crc0 = ~crc;
+  while (size > 0 && reinterpret_cast<uintptr_t>(next) % 8 != 0) {
+    crc0 = _mm_crc32_u8(static_cast<uint32_t>(crc0), *next++);
+    size--;
+  }
+  crc0 = Crc32cBlocks(crc0, next, size, LONG_BLOCK, t.long_shift);
+  crc0 = Crc32cBlocks(crc0, next, size, SHORT_BLOCK, t.short_shift);
+  for (; size >= 8; size -= 8, next += 8) {
+    crc0 = _mm_crc32_u64(crc0, Load64(next));
+  }
+  for (; size > 0; size--) {
+    crc0 = _mm_crc32_u8(static_cast<uint32_t>(crc0), *next++);
+  }
+  return ~static_cast<uint32_t>(crc0);
+}
+#endif
+
+bool Crc32cHasHardware() {
+#if defined(__x86_64__)
+  static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+  return has_sse42;
+#else
+  return false;
+#endif
+}
+
+uint32_t Crc32c(const char *data, size_t size, uint32_t crc) {
+#if defined(__x86_64__)
+  if (Crc32cHasHardware()) {
+    return Crc32cHardware(data, size, crc);
+  }
+#endif
+  return Crc32cSoftware(data, size, crc);
+}
+
+} // namespace scudb
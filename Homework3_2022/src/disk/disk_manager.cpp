@@ -1,32 +1,76 @@
 /**
  * disk_manager.cpp
  */
+#include <algorithm>
 #include <assert.h>
+#include <cerrno>
+#include <climits>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <sys/stat.h>
 #include <thread>
+#include <unistd.h>
 
+#include "common/aligned_buffer.h"
+#include "common/exception.h"
 #include "common/logger.h"
+#include "disk/compressed_page_file.h"
 #include "disk/disk_manager.h"
+#include "page/header_page.h"
 
 namespace scudb {
 
 static char *buffer_used = nullptr;
 
+// first bytes of a page on the free list, followed by the next page's id
+static const uint32_t FREE_PAGE_MAGIC = 0x46524545;
+
+// completion of a transfer that is done already
+static IOCompletion Completed(bool ok) {
+  std::promise<bool> done;
+  done.set_value(ok);
+  return done.get_future();
+}
+
+const page_id_t DiskManager::MIN_EXTENT_PAGES;
+const page_id_t DiskManager::MAX_EXTENT_PAGES;
+const int DiskManager::FILE_ID_SHIFT;
+const int DiskManager::MAX_FILES;
+const page_id_t DiskManager::MAX_FILE_PAGES;
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
+ * @input page_size: page size of a new database file
+ * @input direct_io: bypass the kernel page cache for the db file if possible
+ * @input compress: store the pages of a new database file compressed
+ * @input tablespaces: give every table heap and B+ tree a file of its own
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), flush_log_(false),
-      flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, size_t page_size,
+                         bool direct_io, bool compress, bool tablespaces)
+    : file_name_(db_file), page_size_(page_size), direct_io_(false),
+      io_alignment_(1), tablespaces_(tablespaces), has_async_io_(false),
+      next_page_id_(0), free_list_head_(INVALID_PAGE_ID), has_header_(false),
+      num_flushes_(0), num_reads_(0), num_io_syscalls_(0),
+      num_checksum_failures_(0), flush_log_(false), flush_log_f_(nullptr) {
+  files_[0] = &db_file_;
+  for (int file_id = 1; file_id < MAX_FILES; file_id++) {
+    files_[file_id] = nullptr;
+  }
+  if (!IsValidPageSize(page_size)) {
+    throw Exception(EXCEPTION_TYPE_OUT_OF_RANGE,
+                    "page size must be a power of two in [" +
+                        std::to_string(MIN_PAGE_SIZE) + ", " +
+                        std::to_string(MAX_PAGE_SIZE) + "]");
+  }
   std::string::size_type n = file_name_.find(".");
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
-  log_name_ = file_name_.substr(0, n) + ".log";
+  base_name_ = file_name_.substr(0, n);
+  log_name_ = base_name_ + ".log";
 
   log_io_.open(log_name_,
                std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
@@ -42,21 +86,160 @@ DiskManager::DiskManager(const std::string &db_file)
                                 std::ios::out);
   }
 
-  db_io_.open(db_file,
-              std::ios::binary | std::ios::in | std::ios::out | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  db_file_.fd = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (db_file_.fd < 0) {
+    LOG_DEBUG("can't open db file");
+    return;
+  }
+  struct stat stat_buf;
+  if (fstat(db_file_.fd, &stat_buf) == 0) {
+    db_file_.size = stat_buf.st_size;
+  }
+
+  // a map file next to the db file makes it compressed; an empty db file is
+  // new, any map or tablespaces it has are left over
+  std::string map_name = base_name_ + ".map";
+  if (db_file_.size == 0) {
+    if (compress) {
+      if (truncate(map_name.c_str(), 0) != 0 && errno != ENOENT) {
+        LOG_DEBUG("can't truncate map file");
+      }
+    } else {
+      remove(map_name.c_str());
+    }
+    for (int file_id = 1; file_id < MAX_FILES; file_id++) {
+      remove(GetFileName(file_id).c_str());
+    }
+  } else if (compress && GetFileSize(map_name) <= 0) {
+    LOG_DEBUG("db file is not compressed, keeping it as it is");
+  }
+  if (compress ? db_file_.size == 0 : GetFileSize(map_name) > 0) {
+    compressed_.reset(new CompressedPageFile(db_file_.fd, map_name, page_size_,
+                                             &num_io_syscalls_));
+    if (compressed_->IsOpen() &&
+        IsValidPageSize(compressed_->GetPageSize())) {
+      page_size_ = compressed_->GetPageSize();
+    } else {
+      LOG_DEBUG("can't open map file");
+      compressed_.reset();
+    }
+  }
+
+  // an existing file was written with the page size its header page records,
+  // which also has the free list and the page ids handed out so far
+  char header[HeaderPage::PREFIX_SIZE];
+  bool has_prefix;
+  if (compressed_ != nullptr) {
+    std::vector<char> page(page_size_);
+    has_prefix = ReadPageData(HEADER_PAGE_ID, page.data()) ==
+                 static_cast<ssize_t>(page_size_);
+    memcpy(header, page.data(), HeaderPage::PREFIX_SIZE);
+  } else {
+    has_prefix = db_file_.size >= HeaderPage::PREFIX_SIZE &&
+                 PReadAll(db_file_.fd, header, HeaderPage::PREFIX_SIZE, 0,
+                          &num_io_syscalls_) == HeaderPage::PREFIX_SIZE;
+  }
+  if (has_prefix) {
+    size_t stored = HeaderPage::StoredPageSize(header);
+    if (IsValidPageSize(stored)) {
+      page_size_ = stored;
+      has_header_ = true;
+      next_page_id_ = std::max(0, HeaderPage::StoredNumPages(header));
+      free_list_head_ = HeaderPage::StoredFreeListHead(header);
+    } else {
+      // a header page from before page checksums and the fields above has
+      // its records at byte 4 and no checksum; such a file cannot be read
+      std::vector<char> page(page_size_);
+      if (compressed_ == nullptr &&
+          PReadAll(db_file_.fd, page.data(), page_size_, 0,
+                   &num_io_syscalls_) == static_cast<ssize_t>(page_size_) &&
+          !VerifyPage(HEADER_PAGE_ID, page.data())) {
+        close(db_file_.fd);
+        db_file_.fd = -1;
+        throw Exception(EXCEPTION_TYPE_INCOMPATIBLE_TYPE,
+                        db_file + " was written in the format without page "
+                                  "checksums, it cannot be opened");
+      }
+      LOG_DEBUG("no page size in header page, using %zu", page_size_);
+    }
+  }
+  // pages written since the header page was are in use as well
+  next_page_id_ = std::max(next_page_id_.load(), GetNumPages());
+  if (free_list_head_ <= HEADER_PAGE_ID || free_list_head_ >= next_page_id_) {
+    free_list_head_ = INVALID_PAGE_ID;
+  }
+  if (direct_io && compressed_ != nullptr) {
+    LOG_DEBUG("compressed db file, using buffered I/O");
+  } else if (direct_io) {
+    OpenDirect();
   }
 }
 
+/**
+ * Reopen the db file with O_DIRECT, keeping the buffered descriptor unless
+ * the file system takes direct transfers of whole pages. statx tells the
+ * alignment it needs where the kernel reports it (Linux 6.1+), otherwise
+ * 4096 covers the logical block size of common devices
+ */
+void DiskManager::OpenDirect() {
+#ifdef O_DIRECT
+  int fd = open(file_name_.c_str(), O_RDWR | O_DIRECT);
+  if (fd < 0) {
+    LOG_DEBUG("O_DIRECT not supported: %s, using buffered I/O",
+              strerror(errno));
+    return;
+  }
+  size_t mem_align = 4096, offset_align = 4096;
+#ifdef STATX_DIOALIGN
+  struct statx stx;
+  if (statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 &&
+      (stx.stx_mask & STATX_DIOALIGN)) {
+    // zero alignments: no direct I/O on this file
+    mem_align = stx.stx_dio_mem_align;
+    offset_align = stx.stx_dio_offset_align;
+  }
+#endif
+  if (mem_align == 0 || offset_align == 0 || page_size_ % offset_align != 0) {
+    LOG_DEBUG("O_DIRECT needs %zu byte aligned offsets, using buffered I/O",
+              offset_align);
+    close(fd);
+    return;
+  }
+  close(db_file_.fd);
+  db_file_.fd = fd;
+  direct_io_ = true;
+  io_alignment_ = mem_align;
+#else
+  LOG_DEBUG("O_DIRECT not supported, using buffered I/O");
+#endif
+}
+
 DiskManager::~DiskManager() {
-  db_io_.close();
+  // finishes the transfers still queued
+  async_io_.reset();
+  if (db_file_.fd >= 0) {
+    // unused pages of the extents, last first so they are reused in order;
+    // they are only kept in memory, after a crash they are lost
+    for (auto &run : extents_) {
+      for (page_id_t page_id = run.end - 1; page_id >= run.next; page_id--) {
+        DeallocatePage(page_id);
+      }
+    }
+    std::lock_guard<std::mutex> guard(header_latch_);
+    WriteFreeSpace();
+    compressed_.reset();
+    close(db_file_.fd);
+  }
+  for (int file_id = 1; file_id < MAX_FILES; file_id++) {
+    PageFile *file = files_[file_id];
+    if (file != nullptr) {
+      std::unique_lock<std::mutex> guard(file->latch);
+      WriteFileHeader(file_id, file);
+      guard.unlock();
+      close(file->fd);
+      delete file;
+    }
+  }
   log_io_.close();
 }
 
@@ -64,40 +247,450 @@ DiskManager::~DiskManager() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = page_id * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+  if (page_id == HEADER_PAGE_ID) {
+    WriteHeaderPage(page_data);
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  WritePageData(page_id, page_data);
+}
+
+/**
+ * Write a run of pages to consecutive offsets, the run lands in the file as
+ * one sequential write
+ */
+void DiskManager::WritePages(page_id_t first_page_id, const char *const *pages,
+                             int count) {
+  std::vector<PageWrite> batch;
+  for (int i = 0; i < count; i++) {
+    batch.emplace_back(first_page_id + i, pages[i]);
+  }
+  WritePages(batch);
 }
 
 /**
- * Read the contents of the specified page into the given memory area
+ * Write a batch of pages. Sorted by page id, each run of consecutive ids
+ * becomes one vectored write (up to IOV_MAX / 2 pages, a page and its
+ * checksum are two pieces); a batch of several runs
+ * is queued on the AsyncIO backend all at once, a single run is written
+ * right here. The header page goes on its own, as WritePage writes it.
+ * With sync, the pages are made durable with one fdatasync per file of the
+ * batch rather than one per page
  */
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
+bool DiskManager::WritePages(std::vector<PageWrite> &pages, bool sync) {
+  std::sort(pages.begin(), pages.end());
+  bool ok = true;
+  std::vector<std::unique_ptr<IORequest>> runs;
+  for (size_t i = 0; i < pages.size();) {
+    if (pages[i].first == HEADER_PAGE_ID) {
+      ok = WriteHeaderPage(pages[i].second) && ok;
+      i++;
+      continue;
+    }
+    PageFile *file = GetFile(GetFileId(pages[i].first));
+    if (InCompressedFile(pages[i].first) || file == nullptr) {
+      // the pages have slots of their own size, each goes on its own
+      ok = WritePageData(pages[i].first, pages[i].second) && ok;
+      i++;
+      continue;
+    }
+    size_t count = 1;
+    while (i + count < pages.size() && count < IOV_MAX / 2 &&
+           pages[i + count].first ==
+               pages[i].first + static_cast<page_id_t>(count) &&
+           GetFileId(pages[i + count].first) == GetFileId(pages[i].first)) {
+      count++;
+    }
+    runs.push_back(MakeWriteRun(file, &pages[i], count));
+    i += count;
+  }
+  if (runs.size() == 1) {
+    IORequest &run = *runs[0];
+    ssize_t written =
+        run.iov.empty()
+            ? PWriteAll(run.fd, run.data, run.size, run.offset,
+                        &num_io_syscalls_)
+            : PWriteVAll(run.fd, run.iov.data(),
+                         static_cast<int>(run.iov.size()), run.offset,
+                         &num_io_syscalls_);
+    ok = run.on_done(written) && ok;
+  } else {
+    std::vector<IOCompletion> writes;
+    for (auto &run : runs) {
+      writes.push_back(GetAsyncIO()->Submit(std::move(run)));
+    }
+    for (auto &write : writes) {
+      ok = write.get() && ok;
+    }
+  }
+  for (size_t i = 0; sync && i < pages.size(); i++) {
+    int file_id = GetFileId(pages[i].first);
+    if (i == 0 || file_id != GetFileId(pages[i - 1].first)) {
+      PageFile *file = GetFile(file_id);
+      ok = file != nullptr && Sync(file) && ok;
+    }
+  }
+  return ok;
+}
+
+/**
+ * Request for writing count pages to consecutive page ids from pages[0],
+ * gathering the data of each page and its checksum into one transfer. Under
+ * direct I/O, where every piece would have to be aligned, the run is copied
+ * into a single aligned buffer with the checksums in place instead
+ */
+std::unique_ptr<IORequest> DiskManager::MakeWriteRun(PageFile *file,
+                                                     const PageWrite *pages,
+                                                     size_t count) {
+  std::unique_ptr<IORequest> request(new IORequest());
+  request->is_write = true;
+  request->fd = file->fd;
+  request->data = const_cast<char *>(pages[0].second);
+  request->size = count * page_size_;
+  request->offset = PageOffset(pages[0].first);
+  size_t data_size = page_size_ - PAGE_CHECKSUM_SIZE;
+  std::shared_ptr<AlignedBuffer> bounce;
+  std::shared_ptr<std::vector<uint32_t>> checksums;
+  if (direct_io_) {
+    bounce = std::make_shared<AlignedBuffer>(request->size, io_alignment_);
+    for (size_t i = 0; i < count; i++) {
+      char *page = bounce->GetData() + i * page_size_;
+      memcpy(page, pages[i].second, data_size);
+      uint32_t checksum = PageChecksum(page);
+      memcpy(page + data_size, &checksum, PAGE_CHECKSUM_SIZE);
+    }
+    request->data = bounce->GetData();
+  } else {
+    checksums = std::make_shared<std::vector<uint32_t>>(count);
+    for (size_t i = 0; i < count; i++) {
+      (*checksums)[i] = PageChecksum(pages[i].second);
+      request->iov.push_back({const_cast<char *>(pages[i].second), data_size});
+      request->iov.push_back({&(*checksums)[i], PAGE_CHECKSUM_SIZE});
+    }
+  }
+  int64_t end = request->offset + request->size;
+  request->on_done = [this, file, end, bounce, checksums](ssize_t written) {
+    if (written < 0) {
+      LOG_DEBUG("I/O error while writing");
+      return false;
+    }
+    ExtendFileSize(file, end);
+    return true;
+  };
+  return request;
+}
+
+/**
+ * Read the contents of the specified page into the given memory area, and
+ * check it against its checksum (a page not in the file has none)
+ */
+bool DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  PageFile *file = GetFile(GetFileId(page_id));
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (file == nullptr ||
+      (!InCompressedFile(page_id) && PageOffset(page_id) > file->size)) {
     LOG_DEBUG("I/O error while reading");
     // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    return false;
+  }
+  num_reads_++;
+  char *buffer = page_data;
+  if (!IsAligned(page_data)) {
+    buffer = ThreadBounceBuffer();
+  }
+  ssize_t read_count = ReadPageData(page_id, buffer);
+  bool ok = read_count >= 0;
+  if (!ok) {
+    LOG_DEBUG("I/O error while reading");
+    read_count = 0;
+  }
+  if (buffer != page_data) {
+    memcpy(page_data, buffer, read_count);
+  }
+  // if file ends before reading a whole page
+  if (read_count < static_cast<ssize_t>(page_size_)) {
+    LOG_DEBUG("Read less than a page");
+    // std::cerr << "Read less than a page" << std::endl;
+    memset(page_data + read_count, 0, page_size_ - read_count);
+  }
+  return ok && (read_count == 0 || VerifyPage(page_id, page_data));
+}
+
+/**
+ * Queue a read of the page, completed as ReadPage would do it: past the end
+ * of the file or after an error the page reads as zeros (and the completion
+ * is false), a partly written last page is padded with zeros, and a page
+ * that fails its checksum completes false as well. Under direct
+ * I/O an unaligned page_data is read into an aligned buffer and copied over
+ */
+IOCompletion DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  if (InCompressedFile(page_id)) {
+    // the page has to be decompressed anyway, read it right here
+    num_reads_++;
+    ssize_t read_count = ReadPageData(page_id, page_data);
+    if (read_count < 0) {
+      LOG_DEBUG("I/O error while reading");
+      memset(page_data, 0, page_size_);
+      return Completed(false);
+    }
+    return Completed(read_count == 0 || VerifyPage(page_id, page_data));
+  }
+  PageFile *file = GetFile(GetFileId(page_id));
+  std::unique_ptr<IORequest> request(new IORequest());
+  request->is_write = false;
+  request->fd = file != nullptr ? file->fd : -1;
+  request->data = page_data;
+  request->size = page_size_;
+  request->offset = PageOffset(page_id);
+  if (file == nullptr || request->offset > file->size) {
+    LOG_DEBUG("I/O error while reading");
+    memset(page_data, 0, page_size_);
+    return Completed(false);
+  }
+  num_reads_++;
+  std::shared_ptr<AlignedBuffer> bounce;
+  if (!IsAligned(page_data)) {
+    bounce = std::make_shared<AlignedBuffer>(page_size_, io_alignment_);
+    request->data = bounce->GetData();
+  }
+  size_t page_size = page_size_;
+  request->on_done = [this, page_id, page_data, page_size,
+                       bounce](ssize_t read_count) {
+    if (read_count < 0) {
+      LOG_DEBUG("I/O error while reading");
+    }
+    size_t done = read_count < 0 ? 0 : read_count;
+    if (bounce != nullptr) {
+      memcpy(page_data, bounce->GetData(), done);
+    }
+    if (done < page_size) {
+      memset(page_data + done, 0, page_size - done);
+    }
+    return read_count >= 0 && (done == 0 || VerifyPage(page_id, page_data));
+  };
+  return GetAsyncIO()->Submit(std::move(request));
+}
+
+/**
+ * Queue a write of the page, the file size grows when it is done. The header
+ * page is written right away, in order with the free space updates
+ */
+IOCompletion DiskManager::WritePageAsync(page_id_t page_id,
+                                         const char *page_data) {
+  if (page_id == HEADER_PAGE_ID) {
+    return Completed(WriteHeaderPage(page_data));
+  }
+  PageFile *file = GetFile(GetFileId(page_id));
+  if (InCompressedFile(page_id) || file == nullptr) {
+    return Completed(WritePageData(page_id, page_data));
+  }
+  PageWrite page(page_id, page_data);
+  return GetAsyncIO()->Submit(MakeWriteRun(file, &page, 1));
+}
+
+AsyncIO *DiskManager::GetAsyncIO() {
+  std::call_once(async_io_once_, [this] {
+    async_io_ = AsyncIO::Create();
+    has_async_io_ = true;
+  });
+  return async_io_.get();
+}
+
+/**
+ * Aligned buffer of a page for this thread, holds page data during a
+ * synchronous direct transfer, or a page put together to be written
+ */
+char *DiskManager::ThreadBounceBuffer() {
+  static thread_local AlignedBuffer bounce;
+  bounce.Reserve(page_size_, io_alignment_);
+  return bounce.GetData();
+}
+
+/**
+ * Write the header page with the current free list head and page count in
+ * place of whatever the caller's copy has. Page 0 counts as the header page
+ * once a write of it records this file's page size (HeaderPage::Init)
+ */
+bool DiskManager::WriteHeaderPage(const char *page_data) {
+  std::lock_guard<std::mutex> guard(header_latch_);
+  if (!has_header_ && HeaderPage::StoredPageSize(page_data) == page_size_) {
+    has_header_ = true;
+  }
+  if (!has_header_) {
+    return WritePageData(HEADER_PAGE_ID, page_data);
+  }
+  char *copy = ThreadBounceBuffer();
+  if (copy != page_data) {
+    memcpy(copy, page_data, page_size_);
+  }
+  HeaderPage::StoreFreeSpace(copy, free_list_head_, next_page_id_);
+  return WritePageData(HEADER_PAGE_ID, copy);
+}
+
+/**
+ * Update the free space fields of the header page on disk, the rest of it
+ * stays as the last write of the header page left it
+ */
+void DiskManager::WriteFreeSpace() {
+  if (!has_header_) {
+    return;
+  }
+  char *page = ThreadBounceBuffer();
+  if (ReadPageData(HEADER_PAGE_ID, page) != static_cast<ssize_t>(page_size_)) {
+    LOG_DEBUG("I/O error while reading");
+    return;
+  }
+  HeaderPage::StoreFreeSpace(page, free_list_head_, next_page_id_);
+  WritePageData(HEADER_PAGE_ID, page);
+}
+
+/**
+ * Read the link a free page holds to the next one; false if page_id does not
+ * look like a free page or the link leads out of the file (or to its page 0)
+ */
+bool DiskManager::ReadFreeLink(page_id_t page_id, page_id_t &next) {
+  char *page = ThreadBounceBuffer();
+  if (ReadPageData(page_id, page) != static_cast<ssize_t>(page_size_) ||
+      !VerifyPage(page_id, page)) {
+    return false;
+  }
+  uint32_t magic;
+  memcpy(&magic, page, 4);
+  memcpy(&next, page + 4, 4);
+  if (magic != FREE_PAGE_MAGIC) {
+    return false;
+  }
+  if (next == INVALID_PAGE_ID) {
+    return true;
+  }
+  int file_id = GetFileId(page_id);
+  PageFile *file = GetFile(file_id);
+  page_id_t end = file_id == 0 ? next_page_id_.load()
+                               : file != nullptr ? file->next_page_no : 0;
+  return GetFileId(next) == file_id && GetPageNo(next) > 0 &&
+         GetPageNo(next) < end;
+}
+
+/**
+ * Overwrite page_id with a free page: the magic, then the id of the next
+ * free page
+ */
+bool DiskManager::WriteFreeLink(page_id_t page_id, page_id_t next) {
+  char *page = ThreadBounceBuffer();
+  memset(page, 0, page_size_);
+  memcpy(page, &FREE_PAGE_MAGIC, 4);
+  memcpy(page + 4, &next, 4);
+  return WritePageData(page_id, page);
+}
+
+/**
+ * Overwrite a page taken off a free list with zeros, so it no longer looks
+ * free to DeallocatePage
+ */
+bool DiskManager::ClearFreeLink(page_id_t page_id) {
+  char *page = ThreadBounceBuffer();
+  memset(page, 0, page_size_);
+  return WritePageData(page_id, page);
+}
+
+/**
+ * Write page 0 of a tablespace: the page size, its free list head and the
+ * number of pages handed out, where a header page has them
+ */
+bool DiskManager::WriteFileHeader(int file_id, PageFile *file) {
+  char *page = ThreadBounceBuffer();
+  memset(page, 0, page_size_);
+  HeaderPage::StorePageSize(page, page_size_);
+  HeaderPage::StoreFreeSpace(page, file->free_list_head, file->next_page_no);
+  return WritePageData(MakePageId(file_id, 0), page);
+}
+
+/**
+ * Read the page from the db file into data (aligned for direct I/O), as it
+ * is or out of its compressed slot. Returns the bytes read or -errno
+ */
+ssize_t DiskManager::ReadPageData(page_id_t page_id, char *data) {
+  if (InCompressedFile(page_id)) {
+    return compressed_->ReadPage(page_id, data);
+  }
+  PageFile *file = GetFile(GetFileId(page_id));
+  if (file == nullptr) {
+    return -ENOENT;
+  }
+  return PReadAll(file->fd, data, page_size_, PageOffset(page_id),
+                  &num_io_syscalls_);
+}
+
+/**
+ * Write data as the page with its checksum, compressed if the db file is,
+ * and let the file size grow. The checksum goes along as a second piece of
+ * the write; a compressed page, or one for direct I/O, is put together in
+ * this thread's bounce buffer (where data may be already)
+ */
+bool DiskManager::WritePageData(page_id_t page_id, const char *data) {
+  size_t data_size = page_size_ - PAGE_CHECKSUM_SIZE;
+  uint32_t checksum = PageChecksum(data);
+  off_t offset = PageOffset(page_id);
+  PageFile *file = GetFile(GetFileId(page_id));
+  if (file == nullptr) {
+    LOG_DEBUG("no file for page %d", page_id);
+    return false;
+  }
+  ssize_t written;
+  if (InCompressedFile(page_id) || direct_io_) {
+    char *page = ThreadBounceBuffer();
+    if (page != data) {
+      memcpy(page, data, data_size);
+    }
+    memcpy(page + data_size, &checksum, PAGE_CHECKSUM_SIZE);
+    if (InCompressedFile(page_id)) {
+      return compressed_->WritePage(page_id, page);
     }
+    written = PWriteAll(file->fd, page, page_size_, offset, &num_io_syscalls_);
+  } else {
+    struct iovec iov[2] = {{const_cast<char *>(data), data_size},
+                           {&checksum, PAGE_CHECKSUM_SIZE}};
+    written = PWriteVAll(file->fd, iov, 2, offset, &num_io_syscalls_);
   }
+  if (written < 0) {
+    LOG_DEBUG("I/O error while writing");
+    return false;
+  }
+  ExtendFileSize(file, offset + page_size_);
+  return true;
+}
+
+/**
+ * Compare the checksum stored with the page to the one of its data. A page
+ * of zeros has none, it was allocated but never written
+ */
+bool DiskManager::VerifyPage(page_id_t page_id, const char *data) {
+  size_t data_size = page_size_ - PAGE_CHECKSUM_SIZE;
+  uint32_t stored;
+  memcpy(&stored, data + data_size, PAGE_CHECKSUM_SIZE);
+  if (stored == PageChecksum(data) ||
+      (stored == 0 && data[0] == 0 &&
+       memcmp(data, data + 1, data_size - 1) == 0)) {
+    return true;
+  }
+  num_checksum_failures_++;
+  LOG_DEBUG("page %d fails its checksum", page_id);
+  return false;
+}
+
+/**
+ * Make the pages written to the file so far durable, the map of a compressed
+ * file too
+ */
+bool DiskManager::Sync(PageFile *file) {
+  if (compressed_ != nullptr && file == &db_file_) {
+    return compressed_->Sync();
+  }
+  num_io_syscalls_++;
+  if (fdatasync(file->fd) != 0) {
+    LOG_DEBUG("fdatasync failed: %s", strerror(errno));
+    return false;
+  }
+  return true;
 }
 
 /**
@@ -158,16 +751,313 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * With an extent, hand out the next page of its tablespace, if it has one
+ * (a new extent gets one with tablespaces set), or else its next page in
+ * the db file. Once its run is used up, pages on the free list go first,
+ * one at a time; only when the list is empty does it get a new run, twice
+ * as long as the last (up to MAX_EXTENT_PAGES), of new page ids.
+ * Without, reuse the first page on the free list, else take the next new
+ * page id.
+ * The header page drops a reused page from the list on disk before the page
+ * is handed out, so it cannot come back after a restart.
+ * A file has room for 2^FILE_ID_SHIFT page ids, a larger one would name a
+ * page of a tablespace; INVALID_PAGE_ID once they are all handed out
+ */
+page_id_t DiskManager::AllocatePage(PageExtent *extent) {
+  if (extent != nullptr) {
+    std::unique_lock<std::mutex> guard(extent_latch_);
+    if (extent->file_id_ < 0) {
+      extent->file_id_ = tablespaces_ ? CreateTablespace() : 0;
+    }
+    if (extent->file_id_ > 0) {
+      int file_id = extent->file_id_;
+      guard.unlock();
+      return AllocateInFile(file_id);
+    }
+    if (extent->slot_ < 0) {
+      extent->slot_ = static_cast<int>(extents_.size());
+      extents_.push_back({0, 0, 0});
+    }
+    ExtentRun &run = extents_[extent->slot_];
+    if (run.next == run.end) {
+      page_id_t page_id = TakeFreePage();
+      if (page_id != INVALID_PAGE_ID) {
+        return page_id;
+      }
+      run.size = run.size == 0 ? MIN_EXTENT_PAGES
+                               : std::min(2 * run.size, MAX_EXTENT_PAGES);
+      page_id_t count = run.size;
+      run.next = TakePageIds(count);
+      if (run.next == INVALID_PAGE_ID) {
+        run.end = run.next;
+        return INVALID_PAGE_ID;
+      }
+      run.end = run.next + count;
+    }
+    return run.next++;
+  }
+  page_id_t page_id = TakeFreePage();
+  if (page_id != INVALID_PAGE_ID) {
+    return page_id;
+  }
+  page_id_t count = 1;
+  return TakePageIds(count);
+}
+
+/**
+ * Take the first page off the db file's free list, INVALID_PAGE_ID if it is
+ * empty
+ */
+page_id_t DiskManager::TakeFreePage() {
+  if (free_list_head_ == INVALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
+  }
+  std::lock_guard<std::mutex> guard(free_list_latch_);
+  page_id_t page_id = free_list_head_;
+  if (page_id == INVALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
+  }
+  page_id_t next;
+  if (!ReadFreeLink(page_id, next)) {
+    LOG_DEBUG("page %d on the free list is not free, dropping the list",
+              page_id);
+    page_id = next = INVALID_PAGE_ID;
+  }
+  free_list_head_ = next;
+  std::lock_guard<std::mutex> header_guard(header_latch_);
+  WriteFreeSpace();
+  if (page_id != INVALID_PAGE_ID) {
+    ClearFreeLink(page_id);
+  }
+  return page_id;
+}
+
+/**
+ * Take count new page ids of the db file, fewer if only fewer are left (count
+ * is set to what was taken); returns the first, INVALID_PAGE_ID if none is
+ * left
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::TakePageIds(page_id_t &count) {
+  page_id_t next = next_page_id_;
+  page_id_t taken;
+  do {
+    taken = std::min(count, MAX_FILE_PAGES - next);
+    if (taken <= 0) {
+      LOG_DEBUG("no page ids left in the db file");
+      return INVALID_PAGE_ID;
+    }
+  } while (!next_page_id_.compare_exchange_weak(next, next + taken));
+  count = taken;
+  return next;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
+ * Put the page at the head of the free list: it gets the link to the old
+ * head, then the header page is updated. Nothing of the page may be written
+ * afterwards. A page that already is a free page is left alone, linking it
+ * again would make the list a cycle (pages are zeroed when they leave it)
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-  return;
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  int file_id = GetFileId(page_id);
+  page_id_t next;
+  if (file_id > 0) {
+    // the same on the tablespace's own list, see AllocateInFile
+    PageFile *file = GetFile(file_id);
+    if (file == nullptr) {
+      return;
+    }
+    std::lock_guard<std::mutex> guard(file->latch);
+    if (GetPageNo(page_id) == 0 || GetPageNo(page_id) >= file->next_page_no) {
+      return;
+    }
+    if (ReadFreeLink(page_id, next)) {
+      LOG_DEBUG("page %d is free already", page_id);
+      return;
+    }
+    if (!WriteFreeLink(page_id, file->free_list_head)) {
+      return;
+    }
+    file->free_list_head = page_id;
+    WriteFileHeader(file_id, file);
+    return;
+  }
+  if (page_id <= HEADER_PAGE_ID || page_id >= next_page_id_) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(free_list_latch_);
+  if (ReadFreeLink(page_id, next)) {
+    LOG_DEBUG("page %d is free already", page_id);
+    return;
+  }
+  if (!WriteFreeLink(page_id, free_list_head_)) {
+    return;
+  }
+  free_list_head_ = page_id;
+  std::lock_guard<std::mutex> header_guard(header_latch_);
+  WriteFreeSpace();
+}
+
+/**
+ * Next page of a tablespace: the head of its free list, else a new one at
+ * its end. Page 0 is updated when the free list changes; the page count it
+ * has may fall behind, pages written since count as well when the file is
+ * opened again
+ */
+page_id_t DiskManager::AllocateInFile(int file_id) {
+  PageFile *file = GetFile(file_id);
+  if (file == nullptr) {
+    LOG_DEBUG("no tablespace %d", file_id);
+    return INVALID_PAGE_ID;
+  }
+  std::lock_guard<std::mutex> guard(file->latch);
+  page_id_t page_id = file->free_list_head;
+  if (page_id != INVALID_PAGE_ID) {
+    page_id_t next;
+    if (!ReadFreeLink(page_id, next)) {
+      LOG_DEBUG("page %d on the free list is not free, dropping the list",
+                page_id);
+      page_id = next = INVALID_PAGE_ID;
+    }
+    file->free_list_head = next;
+    WriteFileHeader(file_id, file);
+    if (page_id != INVALID_PAGE_ID) {
+      ClearFreeLink(page_id);
+      return page_id;
+    }
+  }
+  if (file->next_page_no >= MAX_FILE_PAGES) {
+    LOG_DEBUG("no page ids left in tablespace %d", file_id);
+    return INVALID_PAGE_ID;
+  }
+  return MakePageId(file_id, file->next_page_no++);
+}
+
+/**
+ * Returns the file of file_id. A tablespace that is not open yet is opened
+ * here, once; the lookup of an open one takes no lock
+ */
+DiskManager::PageFile *DiskManager::GetFile(int file_id) {
+  if (file_id < 0 || file_id >= MAX_FILES) {
+    return nullptr;
+  }
+  PageFile *file = files_[file_id];
+  if (file != nullptr || file_id == 0) {
+    return file;
+  }
+  std::lock_guard<std::mutex> guard(files_latch_);
+  file = files_[file_id];
+  return file != nullptr ? file : OpenFile(file_id, false);
+}
+
+/**
+ * Open the file of tablespace file_id the way the db file is (direct I/O
+ * included); with create, make a new one, failing if the file exists
+ */
+DiskManager::PageFile *DiskManager::OpenFile(int file_id, bool create) {
+  if (db_file_.fd < 0) {
+    return nullptr;
+  }
+  int flags = O_RDWR | (create ? O_CREAT | O_EXCL : 0);
+#ifdef O_DIRECT
+  if (direct_io_) {
+    flags |= O_DIRECT;
+  }
+#endif
+  int fd = open(GetFileName(file_id).c_str(), flags, 0644);
+  if (fd < 0) {
+    return nullptr;
+  }
+  PageFile *file = new PageFile();
+  file->fd = fd;
+  struct stat stat_buf;
+  if (fstat(fd, &stat_buf) == 0) {
+    file->size = stat_buf.st_size;
+  }
+  // the free space page 0 recorded, and pages written since
+  char header[HeaderPage::PREFIX_SIZE];
+  if (file->size >= HeaderPage::PREFIX_SIZE &&
+      PReadAll(fd, header, HeaderPage::PREFIX_SIZE, 0, &num_io_syscalls_) ==
+          HeaderPage::PREFIX_SIZE &&
+      HeaderPage::StoredPageSize(header) == page_size_) {
+    file->next_page_no = HeaderPage::StoredNumPages(header);
+    file->free_list_head = HeaderPage::StoredFreeListHead(header);
+  }
+  file->next_page_no = std::max(
+      file->next_page_no,
+      static_cast<page_id_t>((file->size + page_size_ - 1) / page_size_));
+  page_id_t head = file->free_list_head;
+  if (GetFileId(head) != file_id || GetPageNo(head) == 0 ||
+      GetPageNo(head) >= file->next_page_no) {
+    file->free_list_head = INVALID_PAGE_ID;
+  }
+  files_[file_id] = file;
+  return file;
+}
+
+/**
+ * Make the file of a new tablespace, with the lowest file id no file has
+ */
+int DiskManager::CreateTablespace() {
+  std::lock_guard<std::mutex> guard(files_latch_);
+  for (int file_id = 1; file_id < MAX_FILES; file_id++) {
+    PageFile *file;
+    if (files_[file_id] == nullptr &&
+        (file = OpenFile(file_id, true)) != nullptr) {
+      std::lock_guard<std::mutex> file_guard(file->latch);
+      WriteFileHeader(file_id, file);
+      return file_id;
+    }
+  }
+  LOG_DEBUG("can't create a tablespace, using the db file");
+  return 0;
+}
+
+/**
+ * Drop a tablespace: close its file, if it is open, and delete it
+ */
+bool DiskManager::DropFile(int file_id) {
+  if (file_id <= 0 || file_id >= MAX_FILES) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(files_latch_);
+  PageFile *file = files_[file_id].exchange(nullptr);
+  if (file != nullptr) {
+    close(file->fd);
+    delete file;
+  }
+  return remove(GetFileName(file_id).c_str()) == 0;
+}
+
+/**
+ * Returns the name of the file of file_id: the db file, or a tablespace
+ */
+std::string DiskManager::GetFileName(int file_id) const {
+  if (file_id == 0) {
+    return file_name_;
+  }
+  return base_name_ + "_" + std::to_string(file_id) + ".db";
+}
+
+/**
+ * Returns the length of the free list of the file, following it on disk
+ */
+int DiskManager::GetNumFreePages(int file_id) {
+  PageFile *file = GetFile(file_id);
+  if (file == nullptr) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> guard(file_id == 0 ? free_list_latch_
+                                                 : file->latch);
+  int count = 0;
+  page_id_t page_id = file_id == 0 ? free_list_head_.load()
+                                   : file->free_list_head;
+  page_id_t end = file_id == 0 ? next_page_id_.load() : file->next_page_no;
+  while (page_id != INVALID_PAGE_ID && count < end &&
+         ReadFreeLink(page_id, page_id)) {
+    count++;
+  }
+  return count;
 }
 
 /**
@@ -175,11 +1065,70 @@ void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
  */
 int DiskManager::GetNumFlushes() const { return num_flushes_; }
 
+/**
+ * Returns number of page reads made so far
+ */
+int DiskManager::GetNumReads() const { return num_reads_; }
+
+/**
+ * Returns the number of system calls made for page I/O so far: reads, writes
+ * and syncs of the db file, directly or by the AsyncIO backend
+ */
+uint64_t DiskManager::GetNumIOSyscalls() const {
+  uint64_t count = num_io_syscalls_;
+  if (has_async_io_) {
+    count += async_io_->GetNumSyscalls();
+  }
+  return count;
+}
+
+/**
+ * Returns the number of pages read that failed their checksum
+ */
+int DiskManager::GetNumChecksumFailures() const {
+  return num_checksum_failures_;
+}
+
+/**
+ * Returns the number of pages in the file, anything at or beyond it has
+ * never been written
+ */
+page_id_t DiskManager::GetNumPages(int file_id) {
+  if (file_id == 0 && compressed_ != nullptr) {
+    return compressed_->GetNumPages();
+  }
+  PageFile *file = GetFile(file_id);
+  if (file == nullptr) {
+    return 0;
+  }
+  int64_t size = file->size;
+  int64_t page_size = static_cast<int64_t>(page_size_);
+  return static_cast<page_id_t>((size + page_size - 1) / page_size);
+}
+
+/**
+ * Page sizes a db file may use: powers of two in [MIN_PAGE_SIZE, MAX_PAGE_SIZE]
+ */
+bool DiskManager::IsValidPageSize(size_t page_size) {
+  return page_size >= MIN_PAGE_SIZE && page_size <= MAX_PAGE_SIZE &&
+         (page_size & (page_size - 1)) == 0;
+}
+
 /**
  * Returns true if the log is currently being flushed
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
+/**
+ * Raise the cached db file size to end, concurrent writes may finish in any
+ * order
+ */
+void DiskManager::ExtendFileSize(PageFile *file, int64_t end) {
+  int64_t size = file->size.load();
+  while (size < end && !file->size.compare_exchange_weak(size, end)) {
+  }
+}
+
 /**
  * Private helper function to get disk file size
  */
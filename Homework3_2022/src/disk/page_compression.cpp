@@ -0,0 +1,177 @@
+/**
+ * page_compression.cpp
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "disk/page_compression.h"
+
+namespace scudb {
+
+static const size_t MIN_MATCH = 4;
+static const size_t MAX_OFFSET = 65535;
+static const int HASH_BITS = 12;
+
+static inline uint32_t Load32(const char *data) {
+  uint32_t value;
+  memcpy(&value, data, 4);
+  return value;
+}
+
+static inline uint32_t Hash(uint32_t sequence) {
+  return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+// a length past the 15 the token holds: 255s, then the rest
+static bool PutLength(char *&op, char *end, size_t length) {
+  for (; length >= 255; length -= 255) {
+    if (op == end) {
+      return false;
+    }
+    *op++ = static_cast<char>(255);
+  }
+  if (op == end) {
+    return false;
+  }
+  *op++ = static_cast<char>(length);
+  return true;
+}
+
+static bool GetLength(const unsigned char *&ip, const unsigned char *end,
+                      size_t &length) {
+  unsigned char byte;
+  do {
+    if (ip == end) {
+      return false;
+    }
+    byte = *ip++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+// literals followed by a match, or just the literals if match_length is 0
+static bool PutSequence(char *&op, char *end, const char *literals,
+                        size_t literal_length, size_t offset,
+                        size_t match_length) {
+  if (op == end) {
+    return false;
+  }
+  size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+  *op++ = static_cast<char>((std::min<size_t>(literal_length, 15) << 4) |
+                            std::min<size_t>(match_code, 15));
+  if (literal_length >= 15 && !PutLength(op, end, literal_length - 15)) {
+    return false;
+  }
+  if (static_cast<size_t>(end - op) < literal_length) {
+    return false;
+  }
+  memcpy(op, literals, literal_length);
+  op += literal_length;
+  if (match_length == 0) {
+    return true;
+  }
+  if (end - op < 2) {
+    return false;
+  }
+  *op++ = static_cast<char>(offset & 0xff);
+  *op++ = static_cast<char>(offset >> 8);
+  return match_code < 15 || PutLength(op, end, match_code - 15);
+}
+
+/*
+ * Greedy: take the first match the hash table offers and skip past it. Where
+ * no match turns up for a while the scan speeds up, so data that does not
+ * compress costs little
+ */
+size_t CompressBlock(const char *src, size_t size, char *dst,
+                     size_t capacity) {
+  // position + 1 of the last 4 bytes seen with each hash, 0 for none
+  uint32_t table[1 << HASH_BITS];
+  memset(table, 0, sizeof(table));
+  char *op = dst;
+  char *end = dst + capacity;
+  size_t anchor = 0; // first byte not yet written out
+  size_t i = 0;
+  while (i + MIN_MATCH <= size) {
+    uint32_t sequence = Load32(src + i);
+    uint32_t &slot = table[Hash(sequence)];
+    size_t candidate = slot;
+    slot = static_cast<uint32_t>(i + 1);
+    if (candidate == 0 || i - (candidate - 1) > MAX_OFFSET ||
+        Load32(src + candidate - 1) != sequence) {
+      i += 1 + ((i - anchor) >> 5);
+      continue;
+    }
+    size_t ref = candidate - 1;
+    size_t length = MIN_MATCH;
+    while (i + length < size && src[ref + length] == src[i + length]) {
+      length++;
+    }
+    if (!PutSequence(op, end, src + anchor, i - anchor, i - ref, length)) {
+      return 0;
+    }
+    i += length;
+    anchor = i;
+  }
+  if (!PutSequence(op, end, src + anchor, size - anchor, 0, 0)) {
+    return 0;
+  }
+  return op - dst;
+}
+
+bool DecompressBlock(const char *src, size_t src_size, char *dst,
+                     size_t size) {
+  const unsigned char *ip = reinterpret_cast<const unsigned char *>(src);
+  const unsigned char *iend = ip + src_size;
+  char *op = dst;
+  char *oend = dst + size;
+  while (ip < iend) {
+    unsigned token = *ip++;
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !GetLength(ip, iend, literal_length)) {
+      return false;
+    }
+    if (static_cast<size_t>(iend - ip) < literal_length ||
+        static_cast<size_t>(oend - op) < literal_length) {
+      return false;
+    }
+    memcpy(op, ip, literal_length);
+    op += literal_length;
+    ip += literal_length;
+    if (ip == iend) {
+      // the last sequence has no match
+      break;
+    }
+    if (iend - ip < 2) {
+      return false;
+    }
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > static_cast<size_t>(op - dst)) {
+      return false;
+    }
+    size_t match_length = token & 15;
+    if (match_length == 15 && !GetLength(ip, iend, match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (static_cast<size_t>(oend - op) < match_length) {
+      return false;
+    }
+    const char *match = op - offset;
+    if (offset >= match_length) {
+      memcpy(op, match, match_length);
+    } else {
+      // the match overlaps what it produces, repeating the last offset bytes
+      for (size_t k = 0; k < match_length; k++) {
+        op[k] = match[k];
+      }
+    }
+    op += match_length;
+  }
+  return op == oend;
+}
+
+} // namespace scudb
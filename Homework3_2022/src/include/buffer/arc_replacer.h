@@ -0,0 +1,107 @@
+/**
+ * arc_replacer.h
+ *
+ * Functionality: Adaptive Replacement Cache (Megiddo & Modha). Resident frames
+ * are kept in two LRU lists, T1 (seen once recently) and T2 (seen at least
+ * twice), and the pages last evicted from each are remembered in the ghost
+ * lists B1 and B2. A miss on a page found in B1 means T1 was too small, a miss
+ * found in B2 means T2 was too small; the target size of T1 moves accordingly,
+ * so the recency/frequency split follows the workload online.
+ *
+ * The replacer only sees frames: Insert is called when a frame becomes
+ * unpinned, so a frame that was never seen before (or now holds another page)
+ * is a miss and everything else is a hit. Pinned frames stay in their list and
+ * are passed over by Victim.
+ * Victim is asked before the missing page is known, hence ghost hits adjust
+ * the target when the page is first unpinned, one eviction later than in the
+ * original algorithm. As with LRU-K, back-to-back references to one frame
+ * within correlated_period ticks count as a single reference.
+ */
+
+#pragma once
+
+#include "buffer/replacer.h"
+#include "page/page.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace scudb {
+
+// identity of the page held by a frame, remembered in the ghost lists
+template <typename T> inline int64_t ArcKeyOf(const T &value) {
+  return static_cast<int64_t>(value);
+}
+inline int64_t ArcKeyOf(Page *const &page) { return page->GetPageId(); }
+
+template <typename T> class ARCReplacer : public Replacer<T> {
+private:
+    enum class eList { T1, T2 };
+    struct sEntry {
+        eList list;
+        typename std::list<T>::iterator pos;
+        int64_t key;
+        uint64_t last_ref;
+        bool evictable;
+        // brought in by read-ahead, its first use is not a hit
+        bool prefetched;
+    };
+
+public:
+  // capacity is the number of frames in the pool (c in the paper)
+  explicit ARCReplacer(size_t capacity, uint64_t correlated_period = 1);
+
+  ~ARCReplacer();
+
+  void Insert(const T &value);
+
+  void InsertPrefetched(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+  void Candidates(std::vector<T> &out, size_t n);
+
+  // move the page to its ghost list, like Victim does
+  bool Evict(const T &value);
+
+  // drop the frame without a ghost, its page is gone
+  void Forget(const T &value);
+
+  // target size of T1 (p in the paper), in frames
+  size_t GetTargetSize();
+
+  // c changes with the pool, the target and ghost lists are cut down to it
+  void SetCapacity(size_t capacity);
+
+private:
+  void Reference(const T &value, bool prefetched);
+  bool EvictFrom(std::list<T> &list, T &value);
+  void EvictEntry(typename std::unordered_map<T, sEntry>::iterator it);
+  // the list Victim takes from first
+  bool PreferT1() const { return !mT1.empty() && mT1.size() > mTarget; }
+  void RemoveGhost(std::list<int64_t> &ghost, int64_t key);
+  void TrimGhosts();
+
+  size_t mCapacity;
+  uint64_t mCorrelatedPeriod;
+  uint64_t mClock;
+  size_t mTarget;
+  size_t mSize;  // number of evictable frames
+  // resident frames, most recently used at the front
+  std::list<T> mT1;
+  std::list<T> mT2;
+  std::unordered_map<T, sEntry> mEntries;
+  // keys of evicted pages, most recently evicted at the front
+  std::list<int64_t> mB1;
+  std::list<int64_t> mB2;
+  std::unordered_map<int64_t, std::pair<eList, std::list<int64_t>::iterator>> mGhosts;
+  mutable std::mutex mLatch;
+};
+
+} // namespace scudb
@@ -0,0 +1,46 @@
+/**
+ * buffer_access_strategy.h
+ *
+ * Functionality: Lets a bulk reader (a full table scan, a leaf chain walk)
+ * keep to a small private ring of frames. When a FetchPage through the
+ * strategy misses, the frame the ring used ring_size misses ago is recycled
+ * if it still holds the page the ring put there and nobody pinned it since.
+ * Otherwise the pool picks a victim as usual and that frame joins the ring.
+ * A scan then evicts mostly its own pages instead of the shared hot ones.
+ *
+ * A ring size of 0 leaves replacement alone and only counts the hits and
+ * misses of the reader. A strategy belongs to one reader (thread) at a time.
+ */
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+
+namespace scudb {
+
+class Page;
+
+class BufferAccessStrategy {
+  friend class BufferPoolManager;
+
+public:
+  explicit BufferAccessStrategy(size_t ring_size = 8)
+      : ring_(ring_size, std::make_pair(nullptr, INVALID_PAGE_ID)) {}
+
+  inline size_t GetRingSize() const { return ring_.size(); }
+  // FetchPage calls made through this strategy
+  inline size_t GetHits() const { return hits_; }
+  inline size_t GetMisses() const { return misses_; }
+
+private:
+  // frames the reader loaded and the page it loaded into each
+  std::vector<std::pair<Page *, page_id_t>> ring_;
+  size_t next_ = 0;  // slot recycled by the next miss
+  size_t hits_ = 0;
+  size_t misses_ = 0;
+};
+
+} // namespace scudb
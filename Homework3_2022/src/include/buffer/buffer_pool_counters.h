@@ -0,0 +1,66 @@
+/**
+ * buffer_pool_counters.h
+ *
+ * Functionality: always-on event counters of one buffer pool. A thread adds
+ * to a stripe picked once for it (round robin over all threads), each stripe
+ * on cache lines of its own, so counting is an uncontended relaxed add on the
+ * hot paths; Get sums the stripes. With more threads than stripes some
+ * threads share one, which costs cache line traffic but no lost updates.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "common/config.h"
+
+namespace scudb {
+
+enum class BufferPoolCounter {
+  HITS = 0,       // FetchPage found the page in the pool
+  MISSES,         // FetchPage had to read the page from disk
+  EVICTIONS,      // a frame holding a page was given to another page
+  WRITE_BACKS,    // dirty pages written to disk, for any reason
+  SYNC_WRITES,    // write backs a FetchPage/NewPage had to do itself
+  CLEANER_WRITES, // write backs done ahead of eviction by the cleaner
+  NEW_PAGES,      // NewPage calls
+  DELETE_PAGES,   // DeletePage calls that deleted the page
+  PREFETCHES,     // pages read ahead of use by Prefetch
+  RING_REUSES,    // misses that recycled a frame of an access strategy ring
+  READ_FAILURES,  // page reads that failed (I/O error, checksum), not installed
+  LATCH_WAITS,    // acquisitions of the pool latch that had to block
+  LATCH_WAIT_NS,  // time spent blocked on the pool latch
+  NUM_COUNTERS
+};
+
+class BufferPoolCounters {
+public:
+  static const size_t NUM_STRIPES = 32;
+
+  BufferPoolCounters();
+  ~BufferPoolCounters();
+
+  inline void Add(BufferPoolCounter counter, size_t n = 1) {
+    stripes_[ThreadStripe()]
+        .values[static_cast<size_t>(counter)]
+        .fetch_add(n, std::memory_order_relaxed);
+  }
+  size_t Get(BufferPoolCounter counter) const;
+
+private:
+  static const size_t NUM_VALUES =
+      static_cast<size_t>(BufferPoolCounter::NUM_COUNTERS);
+  // padded to whole cache lines, the stripes are allocated line aligned
+  struct Stripe {
+    std::atomic<size_t> values[NUM_VALUES];
+    char padding[CACHE_LINE_SIZE -
+                 sizeof(std::atomic<size_t>) * NUM_VALUES % CACHE_LINE_SIZE];
+  };
+
+  static size_t ThreadStripe();
+
+  Stripe *stripes_; // NUM_STRIPES of them
+};
+
+} // namespace scudb
@@ -7,41 +7,199 @@
  */
 
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <list>
 #include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
+#include "buffer/arc_replacer.h"
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_counters.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
+#include "common/aligned_buffer.h"
 #include "disk/disk_manager.h"
-#include "hash/extendible_hash.h"
 #include "logging/log_manager.h"
 #include "page/page.h"
 
 namespace scudb {
+// replacement policy used to pick victims among unpinned frames
+enum class ReplacerType { LRU = 0, CLOCK, LRU_K, ARC };
+
+// counters of one pool (summed over all instances for the parallel manager),
+// see BufferPoolCounter for what they count
+struct BufferPoolStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t write_backs = 0;
+    size_t sync_writes = 0;
+    size_t cleaner_writes = 0;
+    size_t new_pages = 0;
+    size_t delete_pages = 0;
+    size_t prefetches = 0;
+    size_t ring_reuses = 0;
+    size_t read_failures = 0;
+    size_t latch_waits = 0;
+    size_t latch_wait_ns = 0;
+    // frames in use when the stats were taken, see Resize
+    size_t pool_size = 0;
+    // ARC only: frames the policy currently wants for recency (p), 0 otherwise
+    size_t arc_target_size = 0;
+    // frames by pin count when the stats were taken: unpinned (free frames
+    // included), 1, 2-3, 4-7 and 8 or more
+    static const int PIN_BUCKETS = 5;
+    size_t pinned_frames[PIN_BUCKETS] = {};
+
+    BufferPoolStats &operator+=(const BufferPoolStats &other);
+};
+
 class BufferPoolManager {
+    friend class ParallelBufferPoolManager;
+
 public:
+    // max_pool_size is the most frames Resize can grow the pool to, 0 for
+    // pool_size; only the descriptors are allocated for frames not in use
     BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
-                      LogManager *log_manager = nullptr);
-    ~BufferPoolManager();
-    Page *FetchPage(page_id_t page_id);
-    bool UnpinPage(page_id_t page_id, bool is_dirty);
-    bool FlushPage(page_id_t page_id);
-    Page *NewPage(page_id_t &page_id);
-    bool DeletePage(page_id_t page_id);
+                      LogManager *log_manager = nullptr,
+                      ReplacerType replacer_type = ReplacerType::LRU,
+                      size_t max_pool_size = 0);
+    virtual ~BufferPoolManager();
+    // a miss through a strategy with a ring replaces a frame of that ring
+    virtual Page *FetchPage(page_id_t page_id,
+                            BufferAccessStrategy *strategy = nullptr);
+    virtual bool UnpinPage(page_id_t page_id, bool is_dirty);
+    virtual bool FlushPage(page_id_t page_id);
+    // checkpoint: write every dirty page, as one batch of writes in page id
+    // order; pages dirtied meanwhile may or may not be included
+    virtual void FlushAllPages();
+    // the page id comes from extent if one is given, see DiskManager
+    virtual Page *NewPage(page_id_t &page_id, PageExtent *extent = nullptr);
+    virtual bool DeletePage(page_id_t page_id);
+    // drop a tablespace (see DiskManager): its pages leave the pool without
+    // being written, then its file is deleted. False if a page of it is
+    // pinned, that one stays while the others go
+    virtual bool DropFile(int file_id);
+
+    virtual bool CheckAllUnpined();
 
-    bool CheckAllUnpined();
+    virtual BufferPoolStats GetStats();
+
+    // spawn a thread that keeps the clean_frames frames closest to eviction
+    // clean, so misses can evict without writing. A batch it writes is
+    // durable (one fdatasync) before the frames count as clean; evictions
+    // that write a page themselves do not sync
+    virtual void RunCleanerThread(size_t clean_frames);
+    virtual void StopCleanerThread();
+
+    // queue pages [first, first + n) to be read into unpinned frames by a
+    // background thread; pages in the pool or past the end of the file are
+    // skipped, and so is everything once all frames are pinned
+    virtual void Prefetch(page_id_t first, size_t n);
+
+    // grow or shrink the pool to pool_size frames (at most max_pool_size)
+    // while it is in use. Shrinking retires free frames first, then evicts
+    // unpinned ones, writing them back if dirty; pinned frames stay, so the
+    // pool may end up larger than asked. Return the new number of frames
+    virtual size_t Resize(size_t pool_size);
+
+    inline size_t GetPoolSize() const { return pool_size_; }
+    inline size_t GetMaxPoolSize() const { return max_pool_size_; }
+    // size of every page of the pool, the page size of the db file
+    inline size_t GetPageSize() const { return page_size_; }
+
+protected:
+    // for subclasses that route requests to other instances and own no frames
+    BufferPoolManager(DiskManager *disk_manager, LogManager *log_manager);
 
 private:
+    // latch_, counting the time spent waiting for it
+    std::unique_lock<std::mutex> LockLatch();
     Page *GetVictimPage() ;
+    Page *GetRingVictim(BufferAccessStrategy *strategy);
+    Page *FindPage(page_id_t page_id);
+    Page *PinPage(page_id_t page_id);
+    bool ClaimFrame(Page *tar);
+    void FreeFrame(Page *tar);
+    void ReleaseVictim(Page *tar);
+    // the pool part of DropFile
+    bool DiscardFile(int file_id);
+    // bring a page id that was already allocated on disk into the pool
+    Page *NewPageWithId(page_id_t page_id);
+    Page *InstallNewPage(Page *tar, page_id_t page_id,
+                         std::unique_lock<std::mutex> &lck);
+    Page *ReplaceFrame(Page *tar, page_id_t page_id, bool load,
+                       std::unique_lock<std::mutex> &lck);
+    // a failed read was of a page never written, tar now holds its zeros
+    bool PastEndOfFile(Page *tar, page_id_t page_id);
+    // a read into a frame failed: free it once no request holds it
+    void AbandonLoad(Page *tar, page_id_t page_id,
+                     std::unique_lock<std::mutex> &lck);
+    // drop the pin of a request that waited for a read that failed
+    Page *ReleaseFailedLoad(Page *tar);
+    void WaitForWrite(page_id_t page_id, std::unique_lock<std::mutex> &lck);
+    void CleanerLoop();
+    void CleanBatch(std::unique_lock<std::mutex> &lck);
+    void PrefetchLoop();
+    void StopPrefetchThread();
+    // give a retired frame page data again / evict a claimed or free frame
+    // and release its data; caller must hold latch_ through lck
+    bool ActivateFrame(Page *tar);
+    void RetireFrame(Page *tar, std::unique_lock<std::mutex> &lck);
+    // alignment of every buffer handed to the disk manager: a page boundary,
+    // or more if its direct I/O needs more
+    inline size_t GetBufferAlignment() const {
+        return std::max(page_size_, disk_manager_->GetIOAlignment());
+    }
 
-private:
-    size_t pool_size_; // number of pages in buffer pool
-    Page *pages_;      // array of pages
+protected:
+    // number of frames in use; written under latch_, read without it
+    std::atomic<size_t> pool_size_;
+    size_t max_pool_size_; // number of descriptors in pages_
+    size_t page_size_;     // bytes per page
+    // array of page descriptors, cache line aligned; it never moves, so a
+    // Page * stays valid while frames are retired and activated. A retired
+    // frame has no data, a pin count of -1 and no page
+    Page *pages_;
     DiskManager *disk_manager_;
     LogManager *log_manager_;
-    HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
-    Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
+    PageTable *page_table_;        // to keep track of pages
+    // to find an unpinned page for replacement; frames pinned by a hit are
+    // not erased from it, it skips them by their pin count
+    Replacer<Page *> *replacer_;
     std::list<Page *> *free_list_; // to find a free page for replacement
-    std::mutex latch_;             // to protect shared data structure
+    // to protect shared data structure; FetchPage hits and UnpinPage do not
+    // take it, they only read the page table and pin counts
+    std::mutex latch_;
+    BufferPoolCounters counters_;
+    // page cleaner, its settings and state are protected by latch_
+    std::thread *cleaner_thread_ = nullptr;
+    size_t clean_frames_ = 0;      // 0 while no cleaner runs
+    bool cleaner_stop_ = false;
+    AlignedBuffer cleaner_buffer_;
+    std::condition_variable cleaner_cv_;  // wakes the cleaner
+    // pages whose latest content is being written without latch_, the file
+    // is stale for them until every write is done; writes of one page go out
+    // in the order they were queued here
+    std::unordered_multiset<page_id_t> writing_;
+    std::condition_variable written_cv_;  // signaled when a write is done
+    // read-ahead thread, started by the first Prefetch; protected by latch_.
+    // It has up to PREFETCH_BATCH reads in flight, and never more than half
+    // the frames
+    static const size_t PREFETCH_BATCH = 16;
+    std::thread *prefetch_thread_ = nullptr;
+    bool prefetch_stop_ = false;
+    std::deque<page_id_t> prefetch_queue_;
+    std::condition_variable prefetch_cv_;
+    // one Resize at a time, it releases latch_ while writing back
+    std::mutex resize_latch_;
 
 };
 } // namespace scudb
@@ -0,0 +1,59 @@
+/**
+ * clock_replacer.h
+ *
+ * Functionality: CLOCK approximation of LRU over a fixed array of frames. Each
+ * frame has an atomic state byte holding an "evictable" bit and a reference
+ * bit, so Insert/Erase (unpin/pin) are a single atomic operation with no lock
+ * and no allocation. Victim sweeps a clock hand over the frames, clearing
+ * reference bits until it finds an evictable frame that was not referenced
+ * since the last sweep.
+ *
+ * Values are mapped to frames by their offset from a base value: for the
+ * buffer pool the base is the pages_ array, for tests it can be 0.
+ */
+
+#pragma once
+
+#include "buffer/replacer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace scudb {
+
+template <typename T> class ClockReplacer : public Replacer<T> {
+public:
+  // value (base + i) is frame i, for i in [0, num_frames)
+  ClockReplacer(T base, size_t num_frames);
+
+  ~ClockReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+  void Candidates(std::vector<T> &out, size_t n);
+
+private:
+  enum : uint8_t { EVICTABLE = 1, REFERENCED = 2 };
+
+  inline size_t FrameOf(const T &value) const {
+    return static_cast<size_t>(value - base_);
+  }
+
+  T base_;
+  size_t num_frames_;
+  std::unique_ptr<std::atomic<uint8_t>[]> states_;
+  std::atomic<size_t> size_;
+  // the hand only moves inside Victim, which is serialized by hand_latch_
+  size_t hand_;
+  std::mutex hand_latch_;
+};
+
+} // namespace scudb
@@ -0,0 +1,72 @@
+/**
+ * lru_k_replacer.h
+ *
+ * Functionality: LRU-K replacement. For every frame the replacer remembers the
+ * time of its last K references and evicts the evictable frame whose K-th most
+ * recent reference is the oldest (largest backward K-distance). Frames with
+ * fewer than K references have an infinite K-distance and are evicted first,
+ * in LRU order, so pages touched once by a sequential scan leave before pages
+ * that are used again and again, like B+ tree internal pages.
+ *
+ * A reference is an Insert (the frame became unpinned). References that come
+ * within correlated_period ticks of the previous reference to the same frame
+ * (e.g. a scan fetching the same page for every tuple) count as one.
+ */
+
+#pragma once
+
+#include "buffer/replacer.h"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace scudb {
+
+template <typename T> class LRUKReplacer : public Replacer<T> {
+private:
+    // reference history of one frame, oldest first, at most k entries
+    struct sHistory {
+        std::vector<uint64_t> refs;
+        bool evictable = false;
+        // the last reference is a read-ahead, the next one replaces it
+        bool prefetched = false;
+    };
+
+public:
+  explicit LRUKReplacer(size_t k = 2, uint64_t correlated_period = 1);
+
+  ~LRUKReplacer();
+
+  void Insert(const T &value);
+
+  void InsertPrefetched(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+  void Candidates(std::vector<T> &out, size_t n);
+
+  // drop the history of value, like Victim does
+  bool Evict(const T &value);
+
+  void Forget(const T &value);
+
+private:
+  void Reference(const T &value, bool prefetched);
+
+  size_t mK;
+  uint64_t mCorrelatedPeriod;
+  uint64_t mClock;   // logical time, advanced by every reference
+  size_t mSize;      // number of evictable frames
+  // history survives pin/unpin and is dropped when the frame is victimized
+  // or freed
+  std::unordered_map<T, sHistory> mHistoryMap;
+  mutable std::mutex mLatch;
+};
+
+} // namespace scudb
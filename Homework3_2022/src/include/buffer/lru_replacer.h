@@ -44,6 +44,8 @@ public:
 
   size_t Size();
 
+  void Candidates(std::vector<T> &out, size_t n);
+
 private:
   // add your member variables here
   std::shared_ptr<sNode> mHead;
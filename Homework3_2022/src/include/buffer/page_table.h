@@ -0,0 +1,61 @@
+/**
+ * page_table.h
+ *
+ * Functionality: page id -> frame id map of one buffer pool. An open
+ * addressing table with linear probing over a fixed array of atomic slots,
+ * each holding a (page id, frame id) pair in one word. It never holds more
+ * entries than the pool has frames, so it is sized once at twice that and
+ * never grows.
+ *
+ * Find takes no lock and may run concurrently with anything. Insert and
+ * Remove must not run concurrently with each other (the buffer pool calls them
+ * under its latch). Remove shifts the entries that follow back instead of
+ * leaving tombstones, so a Find racing with it can miss an entry being moved;
+ * a caller that must not miss holds the same latch as the writers.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+
+namespace scudb {
+
+class PageTable {
+public:
+  // num_frames: most entries the table will hold
+  explicit PageTable(size_t num_frames);
+  ~PageTable() {}
+
+  bool Find(page_id_t page_id, frame_id_t &frame_id) const;
+  // page_id must not be in the table yet
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+  bool Remove(page_id_t page_id);
+
+private:
+  static const uint64_t EMPTY = ~0ULL;
+
+  inline static uint64_t Pack(page_id_t page_id, frame_id_t frame_id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) |
+           static_cast<uint32_t>(frame_id);
+  }
+  inline static page_id_t PageOf(uint64_t slot) {
+    return static_cast<page_id_t>(slot >> 32);
+  }
+  inline static frame_id_t FrameOf(uint64_t slot) {
+    return static_cast<frame_id_t>(slot & 0xFFFFFFFF);
+  }
+  // page ids are dense, spread them so ids a stride apart do not collide
+  inline size_t HomeOf(page_id_t page_id) const {
+    return (static_cast<uint32_t>(page_id) * 2654435769u) >> (32 - bits_);
+  }
+
+  size_t bits_;
+  size_t mask_;
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+};
+
+} // namespace scudb
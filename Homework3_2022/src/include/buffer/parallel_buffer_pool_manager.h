@@ -0,0 +1,85 @@
+/*
+ * parallel_buffer_pool_manager.h
+ *
+ * Functionality: Shards the buffer pool into several independent
+ * BufferPoolManager instances, each with its own frames, page table, replacer
+ * and latch. A page lives in the instance picked by hashing its page_id, so
+ * requests for different pages rarely contend on the same latch. New pages
+ * are spread round-robin over the instances; one made while its own instance
+ * had every frame pinned goes to another instance and stays there until it
+ * is deleted.
+ */
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace scudb {
+class ParallelBufferPoolManager : public BufferPoolManager {
+public:
+    // pool_size is the total number of frames, split evenly over the
+    // instances, and so is max_pool_size
+    ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                              DiskManager *disk_manager,
+                              LogManager *log_manager = nullptr,
+                              ReplacerType replacer_type = ReplacerType::LRU,
+                              size_t max_pool_size = 0);
+    ~ParallelBufferPoolManager();
+    Page *FetchPage(page_id_t page_id,
+                    BufferAccessStrategy *strategy = nullptr) override;
+    bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+    bool FlushPage(page_id_t page_id) override;
+    // checkpoints the instances one after another
+    void FlushAllPages() override;
+    Page *NewPage(page_id_t &page_id, PageExtent *extent = nullptr) override;
+    bool DeletePage(page_id_t page_id) override;
+    // every instance drops its pages, then the file goes
+    bool DropFile(int file_id) override;
+
+    bool CheckAllUnpined() override;
+
+    // counters and ARC target sizes summed over the instances
+    BufferPoolStats GetStats() override;
+
+    // one cleaner per instance, clean_frames is split like the frames
+    void RunCleanerThread(size_t clean_frames) override;
+    void StopCleanerThread() override;
+
+    // every page is queued on the instance that owns it
+    void Prefetch(page_id_t first, size_t n) override;
+
+    // every instance is resized to its share of pool_size
+    size_t Resize(size_t pool_size) override;
+
+    inline size_t GetNumInstances() const { return instances_.size(); }
+
+private:
+    BufferPoolManager *GetInstance(page_id_t page_id);
+    bool Place(page_id_t page_id, size_t instance);
+    template <typename Predicate>
+    void Unplace(Predicate in_placed);
+    inline size_t PlacedHomeOf(page_id_t page_id) const {
+        return (static_cast<uint32_t>(page_id) * 2654435769u) & placed_mask_;
+    }
+
+private:
+    static const uint64_t EMPTY = ~0ULL;
+    static const uint64_t TOMBSTONE = ~0ULL - 1; // page id -1 matches nothing
+
+    std::vector<BufferPoolManager *> instances_;
+    // pages not on the instance their page_id hashes to, see NewPage: open
+    // addressing over (page id, instance) slots like PageTable, read by
+    // GetInstance without a lock. Removal leaves a tombstone instead of
+    // moving entries, so a lookup never misses one; writers hold placed_latch_
+    std::unique_ptr<std::atomic<uint64_t>[]> placed_;
+    size_t placed_mask_ = 0;
+    size_t placed_used_ = 0;            // entries and tombstones
+    std::mutex placed_latch_;
+    std::atomic<size_t> num_placed_{0}; // entries
+    std::atomic<size_t> next_instance_{0};
+};
+} // namespace scudb
@@ -0,0 +1,43 @@
+/**
+ * read_ahead.h
+ *
+ * Functionality: Sequential read-ahead for iterators that walk a chain of
+ * pages (table heap pages, B+ tree leaves). The iterator reports every page
+ * it moves to; while the page ids keep going up by one, the pages after it
+ * are handed to BufferPoolManager::Prefetch. The window starts small, doubles
+ * each time the reader gets halfway through what was prefetched, and is
+ * dropped as soon as the access stops being sequential.
+ *
+ * A reader confined to a BufferAccessStrategy ring gets no read-ahead, the
+ * prefetched pages would land in the shared part of the pool.
+ */
+
+#pragma once
+
+#include "common/config.h"
+
+namespace scudb {
+
+class BufferAccessStrategy;
+class BufferPoolManager;
+
+class ReadAhead {
+public:
+  ReadAhead(BufferPoolManager *buffer_pool_manager,
+            BufferAccessStrategy *strategy = nullptr);
+
+  // the iterator is about to fetch page_id
+  void Access(page_id_t page_id);
+
+  inline size_t GetWindow() const { return window_; }
+
+private:
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t last_page_id_;
+  // pages before prefetched_end_ have been handed to Prefetch
+  page_id_t prefetched_end_;
+  size_t window_;
+  size_t max_window_;
+};
+
+} // namespace scudb
@@ -6,6 +6,8 @@
 #pragma once
 
 #include <cstdlib>
+#include <functional>
+#include <vector>
 
 namespace scudb {
 
@@ -14,9 +16,38 @@ public:
   Replacer() {}
   virtual ~Replacer() {}
   virtual void Insert(const T &value) = 0;
+  // Insert for a frame that was read ahead and is not used yet: the load is
+  // not a reference, so its first use does not count as a second one
+  virtual void InsertPrefetched(const T &value) { Insert(value); }
   virtual bool Victim(T &value) = 0;
   virtual bool Erase(const T &value) = 0;
   virtual size_t Size() = 0;
+  // append up to n evictable values to out, next victim first, without
+  // removing them (the page cleaner writes these back ahead of eviction)
+  virtual void Candidates(std::vector<T> &out, size_t n) = 0;
+  // remove value as if Victim had picked it, false if it is not evictable
+  virtual bool Evict(const T &value) { return Erase(value); }
+  // drop value and everything remembered about it, evictable or not: its
+  // frame was freed and the next page it holds starts without a history
+  virtual void Forget(const T &value) { Erase(value); }
+  // the pool now has capacity frames (it was resized); for policies that
+  // size their history by the pool
+  virtual void SetCapacity(size_t) {}
+
+  // values that is_pinned holds true for were pinned without an Erase (the
+  // buffer pool's FetchPage hits); Victim and Candidates pass over them and
+  // leave them in place. Set before the replacer is shared between threads
+  void SetPinnedCheck(std::function<bool(const T &)> is_pinned) {
+    is_pinned_ = is_pinned;
+  }
+
+protected:
+  inline bool IsPinned(const T &value) const {
+    return is_pinned_ && is_pinned_(value);
+  }
+
+private:
+  std::function<bool(const T &)> is_pinned_;
 };
 
 } // namespace scudb
@@ -0,0 +1,49 @@
+/**
+ * aligned_buffer.h
+ *
+ * Heap buffer at a given alignment, for page I/O buffers that O_DIRECT
+ * transfers need aligned.
+ */
+
+#pragma once
+
+#include <cstdlib>
+#include <new>
+
+namespace scudb {
+class AlignedBuffer {
+public:
+  AlignedBuffer() {}
+  AlignedBuffer(size_t size, size_t alignment) { Reserve(size, alignment); }
+  ~AlignedBuffer() { free(data_); }
+
+  AlignedBuffer(const AlignedBuffer &) = delete;
+  AlignedBuffer &operator=(const AlignedBuffer &) = delete;
+
+  // at least size bytes at alignment (a power of two); a buffer that is
+  // reallocated does not keep its contents
+  void Reserve(size_t size, size_t alignment) {
+    if (size <= size_ && alignment <= alignment_) {
+      return;
+    }
+    void *memory = nullptr;
+    if (posix_memalign(&memory, alignment < sizeof(void *) ? sizeof(void *)
+                                                           : alignment,
+                       size == 0 ? 1 : size) != 0) {
+      throw std::bad_alloc();
+    }
+    free(data_);
+    data_ = static_cast<char *>(memory);
+    size_ = size;
+    alignment_ = alignment;
+  }
+
+  inline char *GetData() { return data_; }
+  inline size_t GetSize() const { return size_; }
+
+private:
+  char *data_ = nullptr;
+  size_t size_ = 0;
+  size_t alignment_ = 0;
+};
+} // namespace scudb
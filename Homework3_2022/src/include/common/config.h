@@ -16,17 +16,26 @@ extern std::chrono::duration<long long int> LOG_TIMEOUT;
 
 extern std::atomic<bool> ENABLE_LOGGING;
 
+extern std::chrono::milliseconds CLEANER_TIMEOUT;
+
 #define INVALID_PAGE_ID -1 // representing an invalid page id
 #define INVALID_TXN_ID -1  // representing an invalid txn id
 #define INVALID_LSN -1     // representing an invalid lsn
 #define HEADER_PAGE_ID 0   // the header page id
-#define PAGE_SIZE 512     // size of a data page in byte
+#define PAGE_SIZE 512     // default size of a data page in byte
+// a db file may use any power of two page size in this range, see DiskManager
+#define MIN_PAGE_SIZE 512
+#define MAX_PAGE_SIZE 65536
+// the last bytes of every page hold its checksum, see DiskManager
+#define PAGE_CHECKSUM_SIZE 4
 #define LOG_BUFFER_SIZE                                                            \
   ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE) // size of a log buffer in byte
+#define CACHE_LINE_SIZE 64             // alignment of per-frame metadata
 #define BUCKET_SIZE 50                 // size of extendible hash bucket
 #define BUFFER_POOL_SIZE 10            // size of buffer pool
 
 typedef int32_t page_id_t; // page id type
+typedef int32_t frame_id_t; // index of a frame in one buffer pool
 typedef int32_t txn_id_t;  // transaction id type
 typedef int32_t lsn_t;     // log sequence number type
 
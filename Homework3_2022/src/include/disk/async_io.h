@@ -0,0 +1,104 @@
+/**
+ * async_io.h
+ *
+ * Functionality: asynchronous positional reads and writes on a file
+ * descriptor, for the disk manager. Submit queues a request and returns at
+ * once with a completion (a future that becomes true if the whole transfer
+ * succeeded); one backend thread picks up everything queued since it last
+ * looked and submits it as one batch.
+ *
+ * Two backends: io_uring, driven with the raw system calls (no liburing),
+ * which submits a batch with a single io_uring_enter; and a pool of threads
+ * doing pread/pwrite, used where io_uring is not available (old kernels,
+ * seccomp filters). Create picks the first that works.
+ *
+ * A write may gather several buffers into one transfer (IORequest::iov), so
+ * a run of pages bound for consecutive offsets costs a single request.
+ * GetNumSyscalls counts the system calls a backend made for its transfers.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scudb {
+
+// true once the transfer is done, false if it failed
+using IOCompletion = std::future<bool>;
+
+enum class AsyncIOType { IO_URING = 0, THREAD_POOL };
+
+struct IORequest {
+  bool is_write;
+  int fd;
+  char *data;
+  size_t size;
+  off_t offset;
+  // writes only: if not empty, the buffers written in order in place of data;
+  // size is their total
+  std::vector<struct iovec> iov;
+  // run by the backend thread with the bytes transferred (-errno on error),
+  // its result completes the request
+  std::function<bool(ssize_t)> on_done;
+  std::promise<bool> done;
+};
+
+class AsyncIO {
+public:
+  virtual ~AsyncIO() {}
+
+  // io_uring if the kernel lets us set up a ring, the thread pool otherwise
+  static std::unique_ptr<AsyncIO> Create();
+  // the given backend, nullptr if it is not available here
+  static std::unique_ptr<AsyncIO> Create(AsyncIOType type);
+
+  IOCompletion Submit(std::unique_ptr<IORequest> request);
+
+  virtual AsyncIOType GetType() const = 0;
+  inline uint64_t GetNumSyscalls() const { return num_syscalls_; }
+
+protected:
+  AsyncIO() {}
+  // backend threads: wait for requests and take up to max of them, or none
+  // once Shutdown was called and the queue is empty
+  std::vector<std::unique_ptr<IORequest>> TakeRequests(size_t max, bool block);
+  // let the backend threads finish what was queued and exit
+  void Shutdown();
+  static void Complete(std::unique_ptr<IORequest> request, ssize_t result);
+  // the request's transfer from done bytes on, done synchronously
+  ssize_t Transfer(IORequest &request, size_t done);
+
+  std::atomic<uint64_t> num_syscalls_{0};
+
+private:
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::deque<std::unique_ptr<IORequest>> queue_;
+  bool stop_ = false;
+};
+
+// pread/pwrite all of size bytes at offset, resuming after short transfers
+// and signals; the read stops early at the end of the file. Return the bytes
+// transferred or -errno. syscalls, if given, counts the calls made
+ssize_t PReadAll(int fd, char *data, size_t size, off_t offset,
+                 std::atomic<uint64_t> *syscalls = nullptr);
+ssize_t PWriteAll(int fd, const char *data, size_t size, off_t offset,
+                  std::atomic<uint64_t> *syscalls = nullptr);
+// pwritev all of the iovcnt buffers to consecutive offsets from offset, as
+// PWriteAll does
+ssize_t PWriteVAll(int fd, const struct iovec *iov, int iovcnt, off_t offset,
+                   std::atomic<uint64_t> *syscalls = nullptr);
+
+} // namespace scudb
@@ -0,0 +1,85 @@
+/**
+ * compressed_page_file.h
+ *
+ * Functionality: the compressed format of a db file. Every page is stored
+ * compressed (CompressBlock) in a slot of whole SLOT_SIZE byte units, just
+ * big enough for it; a page that does not compress is stored as it is, in
+ * a slot of a full page. Slots lie anywhere in the db file, so a map file
+ * records for every page id where its slot starts and how many bytes are
+ * stored there. A page id with nothing stored reads as zeros.
+ *
+ * A page rewritten to the same number of units stays in its slot. Otherwise
+ * it moves to a free slot of the new size (or splits a larger one, or goes
+ * at the end of the file) and its old slot is freed once the map no longer
+ * points to it. Free slots are known in memory only: on open, the gaps
+ * between the slots in the map are free.
+ *
+ * As with the disk manager, threads may read and write pages at the same
+ * time, just not read a page while it is being written.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include "common/config.h"
+
+namespace scudb {
+
+class CompressedPageFile {
+public:
+  static const size_t SLOT_SIZE = 64;
+
+  // slots go in db_fd, the map in map_file. An existing map keeps the page
+  // size it was made with, a new one gets page_size. syscalls, if given,
+  // counts the system calls made for I/O
+  CompressedPageFile(int db_fd, const std::string &map_file, size_t page_size,
+                     std::atomic<uint64_t> *syscalls = nullptr);
+  ~CompressedPageFile();
+
+  // false if the map could not be opened or is no map of this format
+  inline bool IsOpen() const { return map_fd_ >= 0; }
+  inline size_t GetPageSize() const { return page_size_; }
+
+  // read the page into page_data; returns the bytes of the page found, 0 if
+  // none were ever written (page_data is zeroed), or -errno
+  ssize_t ReadPage(page_id_t page_id, char *page_data);
+  bool WritePage(page_id_t page_id, const char *page_data);
+  // make the slots and the map written so far durable
+  bool Sync();
+  // page ids up to the last one stored
+  page_id_t GetNumPages();
+  // bytes of the db file up to the end of the last slot
+  int64_t GetDataSize();
+
+private:
+  // map entry of a page
+  struct Slot {
+    uint32_t unit;   // offset in the db file, in SLOT_SIZE units
+    uint32_t length; // bytes stored, 0 for none, page_size_ if uncompressed
+  };
+  static inline uint32_t Units(size_t length) {
+    return static_cast<uint32_t>((length + SLOT_SIZE - 1) / SLOT_SIZE);
+  }
+  void LoadMap();
+  // caller holds latch_
+  uint32_t AllocateSlot(uint32_t units);
+  void FreeSpace(uint32_t unit, uint32_t units);
+
+  int db_fd_;
+  int map_fd_;
+  size_t page_size_;
+  std::atomic<uint64_t> *syscalls_;
+  std::mutex latch_;
+  std::vector<Slot> map_;
+  // free slots of each number of units, up to a full page
+  std::vector<std::vector<uint32_t>> free_slots_;
+  uint32_t end_unit_;
+};
+
+} // namespace scudb
@@ -0,0 +1,27 @@
+/**
+ * crc32c.h
+ *
+ * Functionality: CRC-32C (Castagnoli polynomial), the checksum the disk
+ * manager stores with every page. On x86 CPUs with SSE4.2 it is computed
+ * with the crc32 instruction, on three parts of the data at once so the
+ * instruction's latency is hidden, and the three CRCs are combined; on
+ * others it is computed from tables, eight bytes per step (slicing-by-8).
+ * Both give the same values.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace scudb {
+
+// CRC-32C of size bytes at data, continuing from crc (the CRC of the bytes
+// before them, 0 for none)
+uint32_t Crc32c(const char *data, size_t size, uint32_t crc = 0);
+// the same from the tables, whatever the CPU
+uint32_t Crc32cSoftware(const char *data, size_t size, uint32_t crc = 0);
+// true if Crc32c uses the crc32 instruction
+bool Crc32cHasHardware();
+
+} // namespace scudb
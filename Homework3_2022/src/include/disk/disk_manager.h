@@ -5,49 +5,295 @@
  * database. It also performs read and write of pages to and from disk, and
  * provides a logical file layer within the context of a database management
  * system.
+ *
+ * Pages are read and written with pread/pwrite on a file descriptor, which
+ * take the file offset as an argument, so any number of threads can do page
+ * I/O at the same time without a lock. The log file keeps using a stream.
+ * The *Async calls queue the transfer on an AsyncIO backend (io_uring, or a
+ * thread pool), started by the first of them; page_data must stay valid
+ * until the returned completion is ready.
+ *
+ * With direct_io the db file is opened with O_DIRECT, so pages bypass the
+ * kernel page cache and are cached only by the buffer pool. Transfers then
+ * have to start at GetIOAlignment aligned addresses; pages read into
+ * unaligned memory go through an aligned buffer, and pages written are
+ * copied into one together with their checksum. Where the file system rejects
+ * O_DIRECT, or needs offsets aligned beyond the page size, the file is used
+ * buffered as usual (see IsDirectIO).
+ *
+ * Deallocated pages are kept on a free list that runs through the free pages
+ * themselves, each one holding the id of the next, and AllocatePage takes
+ * from it before handing out new page ids. The head of the list and the
+ * number of page ids handed out are stored in the header page, where a
+ * write of the header page always carries the disk manager's current values;
+ * a file without a header page keeps them in memory only. The header page
+ * itself is never freed.
+ *
+ * A table heap or B+ tree allocates through its own PageExtent, which takes
+ * new page ids in runs (extents) of consecutive pages, so its pages lie
+ * together in the file however the allocations of different owners are
+ * interleaved. Runs start at MIN_EXTENT_PAGES and double up to
+ * MAX_EXTENT_PAGES; pages on the free list are reused before a new run is
+ * taken. What an owner has not used of its last run goes to the free list
+ * when the disk manager is closed. The runs are not stored in the file, so
+ * after a crash those pages (fewer than MAX_EXTENT_PAGES per owner) are
+ * lost: their ids are never handed out again.
+ *
+ * The buffer pool writes dirty pages in batches (WritePages with a vector),
+ * which merge pages of consecutive ids into one pwritev and need at most one
+ * fdatasync per batch. GetNumIOSyscalls counts the system calls page I/O
+ * took.
+ *
+ * A new db file can be made compressed: its pages are stored compressed in
+ * slots of their own size, found through a map file (<name>.map) next to it,
+ * see CompressedPageFile. Callers see whole pages all the same. A db file
+ * with a map stays compressed when opened again, one without stays as it
+ * is. Compressed files are not read or written asynchronously, nor with
+ * direct I/O.
+ *
+ * Every page is written with a CRC-32C of its first page size -
+ * PAGE_CHECKSUM_SIZE bytes in the last PAGE_CHECKSUM_SIZE, which page
+ * layouts leave free (Page::GetUsableSize). Reads check it: a page that does
+ * not match is logged and counted (GetNumChecksumFailures), and the read
+ * returns false. A page of zeros is one that was never written and passes.
+ *
+ * Besides the db file (file 0), a table heap or B+ tree can have a file of
+ * its own, a tablespace: <name>_<file id>.db next to the db file. The file
+ * id of a page is in the high bits of its page id (GetFileId, MakePageId),
+ * so a page id finds its file on its own, and tablespace files are opened
+ * the first time one of their pages is used. With tablespaces set, every
+ * PageExtent that does not have a file yet gets a new tablespace; its pages
+ * are then numbered from 1 in that file, and page I/O on different files
+ * goes through separate descriptors, a batch with several files in parallel.
+ * Page 0 of a tablespace is its header: it keeps the free list of the file
+ * (run through its free pages as in the db file) and the number of pages
+ * handed out, in the fields the header page has for them. A tablespace is
+ * dropped by deleting its file (DropFile). Tablespaces are never compressed.
+ * Each file has room for MAX_FILE_PAGES pages, AllocatePage returns
+ * INVALID_PAGE_ID when they are used up.
  */
 
 #pragma once
 #include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "disk/async_io.h"
+#include "disk/compressed_page_file.h"
+#include "disk/crc32c.h"
 
 namespace scudb {
 
+// handle of the extents, or the tablespace, of one table heap or B+ tree,
+// see above; used with one disk manager only
+class PageExtent {
+  friend class DiskManager;
+
+public:
+  // allocate in the file of page_id, for an owner that has pages already
+  inline void SetFileOf(page_id_t page_id);
+
+private:
+  int slot_ = -1;    // index into DiskManager::extents_, -1 before first use
+  int file_id_ = -1; // file the pages go to, -1 before first use
+};
+
 class DiskManager {
 public:
-  DiskManager(const std::string &db_file);
+  // page_size must be a power of two in [MIN_PAGE_SIZE, MAX_PAGE_SIZE]; a db
+  // file that already has a header page keeps the page size stored in it
+  DiskManager(const std::string &db_file, size_t page_size = PAGE_SIZE,
+              bool direct_io = false, bool compress = false,
+              bool tablespaces = false);
   ~DiskManager();
 
   void WritePage(page_id_t page_id, const char *page_data);
-  void ReadPage(page_id_t page_id, char *page_data);
+  // write count pages to consecutive page ids starting at first_page_id
+  void WritePages(page_id_t first_page_id, const char *const *pages,
+                  int count);
+  // write the pages of a batch in page id order (pages gets sorted), with
+  // sync return once they are durable; false if any write failed
+  using PageWrite = std::pair<page_id_t, const char *>;
+  bool WritePages(std::vector<PageWrite> &pages, bool sync = false);
+  // false on an I/O error or a page that fails its checksum
+  bool ReadPage(page_id_t page_id, char *page_data);
+  // like ReadPage/WritePage, requests made close together are submitted
+  // as one batch
+  IOCompletion ReadPageAsync(page_id_t page_id, char *page_data);
+  IOCompletion WritePageAsync(page_id_t page_id, const char *page_data);
+  // backend of the *Async calls, starting it if needed
+  AsyncIO *GetAsyncIO();
 
   void WriteLog(char *log_data, int size);
   bool ReadLog(char *log_data, int size, int offset);
 
-  page_id_t AllocatePage();
+  static const page_id_t MIN_EXTENT_PAGES = 4;
+  static const page_id_t MAX_EXTENT_PAGES = 64;
+  // the next page of the extent, a new page id if extent is nullptr
+  page_id_t AllocatePage(PageExtent *extent = nullptr);
   void DeallocatePage(page_id_t page_id);
 
+  // page ids of tablespaces, see above
+  static const int FILE_ID_SHIFT = 24;
+  static const int MAX_FILES = 128;
+  // page ids a file has room for, AllocatePage fails beyond
+  static const page_id_t MAX_FILE_PAGES = 1 << FILE_ID_SHIFT;
+  static inline int GetFileId(page_id_t page_id) {
+    return page_id >> FILE_ID_SHIFT;
+  }
+  static inline page_id_t GetPageNo(page_id_t page_id) {
+    return page_id & ((1 << FILE_ID_SHIFT) - 1);
+  }
+  static inline page_id_t MakePageId(int file_id, page_id_t page_no) {
+    return file_id << FILE_ID_SHIFT | page_no;
+  }
+  // close and delete the tablespace file_id. None of its pages may be used
+  // anymore, nor be in a buffer pool (see BufferPoolManager::DropFile);
+  // false if there is no such file
+  bool DropFile(int file_id);
+  std::string GetFileName(int file_id) const;
+
+  // pages that AllocatePage would reuse in the file
+  int GetNumFreePages(int file_id = 0);
   int GetNumFlushes() const;
+  int GetNumReads() const;
+  uint64_t GetNumIOSyscalls() const;
+  // pages read that failed their checksum
+  int GetNumChecksumFailures() const;
+  // pages the file holds, a partly written last page included
+  page_id_t GetNumPages(int file_id = 0);
   bool GetFlushState() const;
+  inline size_t GetPageSize() const { return page_size_; }
+  // true if direct I/O was asked for and the file system supports it
+  inline bool IsDirectIO() const { return direct_io_; }
+  // alignment page buffers should have, 1 unless IsDirectIO
+  inline size_t GetIOAlignment() const { return io_alignment_; }
+  inline bool IsCompressed() const { return compressed_ != nullptr; }
+  static bool IsValidPageSize(size_t page_size);
   inline void SetFlushLogFuture(std::future<void> *f) { flush_log_f_ = f; }
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
 private:
+  // an open file of pages: the db file or a tablespace
+  struct PageFile {
+    int fd = -1;
+    // size of the file, taken once at open and then kept up to date by the
+    // writes, instead of a stat() per read
+    std::atomic<int64_t> size{0};
+    // tablespaces: next new page number and the first free page, stored in
+    // page 0; changed under latch, which also orders the writes of both
+    std::mutex latch;
+    page_id_t next_page_no = 1;
+    page_id_t free_list_head = INVALID_PAGE_ID;
+  };
   int GetFileSize(const std::string &name);
+  // the file grew to at least end bytes
+  void ExtendFileSize(PageFile *file, int64_t end);
+  // the file of a page id, opening a tablespace if needed; nullptr if there
+  // is none
+  PageFile *GetFile(int file_id);
+  // open (or with create, make) a tablespace; caller holds files_latch_
+  PageFile *OpenFile(int file_id, bool create);
+  // file id of a new tablespace, 0 (the db file) if none can be made
+  int CreateTablespace();
+  page_id_t AllocateInFile(int file_id);
+  page_id_t TakePageIds(page_id_t &count);
+  page_id_t TakeFreePage();
+  inline off_t PageOffset(page_id_t page_id) const {
+    return static_cast<off_t>(GetPageNo(page_id)) * page_size_;
+  }
+  inline bool InCompressedFile(page_id_t page_id) const {
+    return compressed_ != nullptr && GetFileId(page_id) == 0;
+  }
+  // switch the db file to O_DIRECT if the file system can do it with pages
+  // of page_size_
+  void OpenDirect();
+  inline bool IsAligned(const char *data) const {
+    return reinterpret_cast<uintptr_t>(data) % io_alignment_ == 0;
+  }
+  char *ThreadBounceBuffer();
+  // transfers of a whole page at its place in the db file, see the .cpp
+  ssize_t ReadPageData(page_id_t page_id, char *data);
+  bool WritePageData(page_id_t page_id, const char *data);
+  bool Sync(PageFile *file);
+  // checksum of the page's data, without the checksum field
+  inline uint32_t PageChecksum(const char *data) const {
+    return Crc32c(data, page_size_ - PAGE_CHECKSUM_SIZE);
+  }
+  // true if data, read as page_id, has the checksum it was written with
+  bool VerifyPage(page_id_t page_id, const char *data);
+  // write page_data as the header page, with the free space fields filled in
+  bool WriteHeaderPage(const char *page_data);
+  std::unique_ptr<IORequest> MakeWriteRun(PageFile *file,
+                                          const PageWrite *pages,
+                                          size_t count);
+  // store the free space fields into the header page on disk, if the file
+  // has one; caller must hold header_latch_
+  void WriteFreeSpace();
+  // next page on the free list after page_id, read from disk
+  bool ReadFreeLink(page_id_t page_id, page_id_t &next);
+  // make page_id a free page linking to next
+  bool WriteFreeLink(page_id_t page_id, page_id_t next);
+  // zero a page taken off a free list
+  bool ClearFreeLink(page_id_t page_id);
+  // write page 0 of a tablespace; caller holds file->latch
+  bool WriteFileHeader(int file_id, PageFile *file);
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // the db file, its fd is -1 if it could not be opened
+  PageFile db_file_;
   std::string file_name_;
+  // file_name_ up to the extension, for the other files
+  std::string base_name_;
+  size_t page_size_;
+  bool direct_io_;
+  size_t io_alignment_;
+  bool tablespaces_;
+  // by file id, db_file_ and the tablespaces opened so far; opening and
+  // dropping files is done under files_latch_
+  std::atomic<PageFile *> files_[MAX_FILES];
+  std::mutex files_latch_;
+  // set if the db file is compressed
+  std::unique_ptr<CompressedPageFile> compressed_;
+  std::once_flag async_io_once_;
+  std::unique_ptr<AsyncIO> async_io_;
+  // set once async_io_ is, so it can be read without async_io_once_
+  std::atomic<bool> has_async_io_;
   std::atomic<page_id_t> next_page_id_;
+  // first free page, INVALID_PAGE_ID if there is none; changed under
+  // free_list_latch_, which also orders the writes of the free list
+  std::atomic<page_id_t> free_list_head_;
+  std::mutex free_list_latch_;
+  // orders the writes of the header page; has_header_ is set once page 0 was
+  // found to be a header page (it records this file's page size)
+  std::mutex header_latch_;
+  bool has_header_;
+  // current run of every PageExtent: ids [next, end) are still unused
+  struct ExtentRun {
+    page_id_t next;
+    page_id_t end;
+    page_id_t size; // of the run, 0 before the first
+  };
+  std::mutex extent_latch_;
+  std::vector<ExtentRun> extents_;
   int num_flushes_;
+  std::atomic<int> num_reads_;
+  std::atomic<uint64_t> num_io_syscalls_;
+  std::atomic<int> num_checksum_failures_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
 };
 
+inline void PageExtent::SetFileOf(page_id_t page_id) {
+  file_id_ = DiskManager::GetFileId(page_id);
+}
+
 } // namespace scudb
\ No newline at end of file
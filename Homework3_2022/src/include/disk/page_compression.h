@@ -0,0 +1,29 @@
+/**
+ * page_compression.h
+ *
+ * Functionality: fast lossless compression of page images, for the
+ * compressed db file format (see CompressedPageFile). The blocks are in the
+ * LZ4 block format: a sequence of (literals, match) pairs, each a token byte
+ * with the two lengths, the literal bytes, and the match as a 16 bit offset
+ * back into the output; the last sequence has literals only. Matches are
+ * found through a hash table of 4 byte prefixes, with no search for longer
+ * ones, which keeps compression at a few hundred MB/s or more.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace scudb {
+
+// compress size bytes of src into at most capacity bytes of dst; returns the
+// compressed size, 0 if it does not fit
+size_t CompressBlock(const char *src, size_t size, char *dst,
+                     size_t capacity);
+// decompress a block of src_size bytes into exactly size bytes of dst; false
+// if src is not a block of that size (it is never read or written out of
+// bounds, whatever it holds)
+bool DecompressBlock(const char *src, size_t src_size, char *dst,
+                     size_t size);
+
+} // namespace scudb
@@ -45,8 +45,10 @@ namespace scudb {
                       Transaction *transaction = nullptr);
 
         // index iterator
-        INDEXITERATOR_TYPE Begin();
-        INDEXITERATOR_TYPE Begin(const KeyType &key);
+        // a range scan given a strategy keeps to the strategy's ring of frames
+        INDEXITERATOR_TYPE Begin(BufferAccessStrategy *strategy = nullptr);
+        INDEXITERATOR_TYPE Begin(const KeyType &key,
+                                 BufferAccessStrategy *strategy = nullptr);
 
         // Print this B+ tree to stdout using a simple command-line
         std::string ToString(bool verbose = false);
@@ -105,6 +107,9 @@ namespace scudb {
         void TryUnlockRootPageId(bool exclusive) ;
 
         BPlusTreePage *CrabingProtocalFetchPage(page_id_t page_id, OperationType op, page_id_t previous, Transaction *transaction);
+        bool OptimisticFindLeafPage(const KeyType &key, bool leftMost,
+                                    Transaction *transaction,
+                                    B_PLUS_TREE_LEAF_PAGE_TYPE *&leaf);
         void FreePagesInTransaction(bool exclusive,  Transaction *transaction, page_id_t cur = -1);
 
         int isBalanced(page_id_t pid);
@@ -116,6 +121,10 @@ namespace scudb {
         page_id_t root_page_id_;
         BufferPoolManager *buffer_pool_manager_;
         KeyComparator comparator_;
+        // pages are allocated in extents (or a tablespace of the tree's
+        // own), keeping the leaf chain of a tree built in key order together
+        // in the file
+        PageExtent extent_;
 
         RWMutex mMutex_;
         static thread_local int mRootLockedCnt;
@@ -3,6 +3,7 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include "buffer/read_ahead.h"
 #include "page/b_plus_tree_leaf_page.h"
 
 namespace scudb {
@@ -14,7 +15,8 @@ namespace scudb {
     class IndexIterator {
     public:
         // you may define your own constructor based on your member variables
-        IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf, int index, BufferPoolManager *buf_pool_manager);
+        IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf, int index, BufferPoolManager *buf_pool_manager,
+                      BufferAccessStrategy *strategy = nullptr);
         ~IndexIterator();
 
 
@@ -34,6 +36,8 @@ namespace scudb {
         int mIndex_;
         B_PLUS_TREE_LEAF_PAGE_TYPE *mLeafPage_;
         BufferPoolManager *mBufferPoolManager_;
+        BufferAccessStrategy *mStrategy_;
+        ReadAhead mReadAhead_;  // for walking the leaf chain
     };
 
 } // namespace scudb
@@ -32,7 +32,9 @@ namespace scudb {
 class BPlusTreeInternalPage : public BPlusTreePage {
 public:
   // must call initialize method after "create" a new node
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  // the max size is what fits into page_size bytes, the usable size of the
+  // page (Page::GetUsableSize, the page size less its checksum)
+  void Init(page_id_t page_id, page_id_t parent_id, int page_size);
 
   KeyType KeyAt(int index) const;
   void SetKeyAt(int index, const KeyType &key);
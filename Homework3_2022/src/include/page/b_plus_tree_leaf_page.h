@@ -34,7 +34,9 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  // the max size is what fits into page_size bytes, the usable size of the
+  // page (Page::GetUsableSize, the page size less its checksum)
+  void Init(page_id_t page_id, page_id_t parent_id, int page_size);
   // helper methods
   page_id_t GetNextPageId() const;
   void SetNextPageId(page_id_t next_page_id);
@@ -3,12 +3,19 @@
  *
  * Database use the first page (page_id = 0) as header page to store metadata, in
  * our case, we will contain information about table/index name (length less than
- * 32 bytes) and their corresponding root_id
+ * 32 bytes) and their corresponding root_id, and the page size of the file
  *
  * Format (size in byte):
- *  -----------------------------------------------------------------
- * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
- *  -----------------------------------------------------------------
+ *  ----------------------------------------------------------------------------
+ * | RecordCount (4) | PageSize (4) | FreeListHead (4) | NumPages (4) |
+ *  ----------------------------------------------------------------------------
+ * | Entry_1 name (32) | Entry_1 root_id (4) | ...
+ *  ----------------------------------------------------------------------------
+ *
+ * FreeListHead and NumPages belong to the disk manager, which fills them in
+ * whenever it writes the header page: the first page of its free page list
+ * and how many page ids it has handed out. Page 0 of a tablespace file has
+ * the same prefix, without entries
  */
 
 #pragma once
@@ -21,7 +28,21 @@ namespace scudb {
 
 class HeaderPage : public Page {
 public:
-  void Init() { SetRecordCount(0); }
+  void Init() {
+    SetRecordCount(0);
+    SetStoredPageSize(GetPageSize());
+    StoreFreeSpace(GetData(), INVALID_PAGE_ID, 0);
+  }
+  // bytes before the first entry
+  static const int PREFIX_SIZE = 16;
+  // page size recorded in the header page data, 0 if there is none
+  static size_t StoredPageSize(const char *data);
+  static void StorePageSize(char *data, size_t page_size);
+  // disk manager fields, see above
+  static page_id_t StoredFreeListHead(const char *data);
+  static page_id_t StoredNumPages(const char *data);
+  static void StoreFreeSpace(char *data, page_id_t free_list_head,
+                             page_id_t num_pages);
   /**
    * Record related
    */
@@ -32,6 +53,8 @@ public:
   // return root_id if success
   bool GetRootId(const std::string &name, page_id_t &root_id);
   int GetRecordCount();
+  // entries that fit into the page
+  int GetMaxRecordCount();
 
 private:
   /**
@@ -40,5 +63,6 @@ private:
   int FindRecord(const std::string &name);
 
   void SetRecordCount(int record_count);
+  void SetStoredPageSize(size_t page_size);
 };
 } // namespace scudb
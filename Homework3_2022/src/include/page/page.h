@@ -4,10 +4,17 @@
  * Wrapper around actual data page in main memory and also contains bookkeeping
  * information used by buffer pool manager like pin_count/dirty_flag/page_id.
  * Use page as a basic unit within the database system
+ *
+ * The Page object is only the descriptor of a frame, the data lives in a
+ * separate page aligned buffer. Descriptors are cache line aligned, so pinning
+ * or latching one frame never invalidates a line of another frame.
  */
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
 
@@ -16,36 +23,79 @@
 
 namespace scudb {
 
-class Page {
+class alignas(CACHE_LINE_SIZE) Page {
   friend class BufferPoolManager;
 
 public:
-  Page() { ResetMemory(); }
+  Page() {}
   ~Page(){};
   // get actual data page content
   inline char *GetData() { return data_; }
+  // size of the data page, the same for every page of a buffer pool
+  inline size_t GetPageSize() const { return page_size_; }
+  // bytes a page layout may use, the disk manager keeps a checksum after them
+  inline size_t GetUsableSize() const {
+    return page_size_ - PAGE_CHECKSUM_SIZE;
+  }
   // get page id
   inline page_id_t GetPageId() { return page_id_; }
   // get page pin count
   inline int GetPinCount() { return pin_count_; }
   // method use to latch/unlatch page content
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WUnlatch() {
+    // even again: the change is complete
+    version_.store(version_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    // odd while write latched, optimistic readers must not trust the content
+    version_.store(version_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
   inline void RUnlatch() { rwlatch_.RUnlock(); }
   inline void RLatch() { rwlatch_.RLock(); }
+  // optimistic read of a pinned page without latching: remember the version,
+  // read, then RValidate; false if a writer holds the latch right now
+  inline bool ROptimisticLatch(uint64_t &version) {
+    version = version_.load(std::memory_order_acquire);
+    return (version & 1) == 0;
+  }
+  // true if no writer latched the page since ROptimisticLatch returned
+  // version, i.e. what was read in between is consistent
+  inline bool RValidate(uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
 
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + 4); }
   inline void SetLSN(lsn_t lsn) { memcpy(GetData() + 4, &lsn, 4); }
 
 private:
+  // disk I/O on the frame that runs without the buffer pool latch
+  enum class IOState : uint8_t { NONE, LOADING, WRITING };
   // method used by buffer pool manager
-  inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
-  // members
-  char data_[PAGE_SIZE]; // actual data
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  int pin_count_ = 0;
-  bool is_dirty_ = false;
+  inline void ResetMemory() { memset(data_, 0, page_size_); }
+  // members, the ones a FetchPage hit touches come first and share one line
+  char *data_ = nullptr; // actual data, owned by the buffer pool manager
+  size_t page_size_ = 0;
+  // atomic: a FetchPage hit pins the frame and reads these without the
+  // buffer pool latch; pin_count_ is -1 while the buffer pool takes the
+  // frame over
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  std::atomic<int> pin_count_{0};
+  std::atomic<bool> is_dirty_{false};
+  std::atomic<IOState> io_state_{IOState::NONE};
+  // bumped by WLatch and WUnlatch, for optimistic readers
+  std::atomic<uint64_t> version_{0};
   RWMutex rwlatch_;
+  // waited on with the buffer pool latch until io_state_ is NONE
+  std::condition_variable io_cv_;
 };
 
+static_assert(sizeof(Page) % CACHE_LINE_SIZE == 0,
+              "page descriptors must not share cache lines");
+
 } // namespace scudb
@@ -42,11 +42,14 @@ public:
                    Transaction *txn); // when commit delete or rollback insert
   void RollbackDelete(const RID &rid, Transaction *txn); // when rollback delete
 
-  bool GetTuple(const RID &rid, Tuple &tuple, Transaction *txn);
+  bool GetTuple(const RID &rid, Tuple &tuple, Transaction *txn,
+                BufferAccessStrategy *strategy = nullptr);
 
   bool DeleteTableHeap();
 
-  TableIterator begin(Transaction *txn);
+  // a scan given a strategy keeps to the strategy's ring of frames
+  TableIterator begin(Transaction *txn,
+                      BufferAccessStrategy *strategy = nullptr);
 
   TableIterator end();
 
@@ -60,6 +63,9 @@ private:
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_;
+  // new pages come from extents (or a tablespace) of their own, so a scan
+  // reads the file mostly in order
+  PageExtent extent_;
 };
 
 } // namespace scudb
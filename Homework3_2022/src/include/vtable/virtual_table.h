@@ -62,17 +62,29 @@ int VtabBegin(sqlite3_vtab *pVTab);
 // storage engine
 class StorageEngine {
 public:
-  StorageEngine(std::string db_file_name) {
+  // page_size only applies to a new db file, an existing one keeps its own;
+  // the pool can be resized up to max_pool_size frames (0: pool_size);
+  // direct_io keeps db pages out of the kernel page cache where possible;
+  // compress stores the pages of a new db file compressed; tablespaces
+  // gives every new table and index a file of its own; replacer_type is the
+  // replacement policy of the pool
+  StorageEngine(std::string db_file_name, size_t page_size = PAGE_SIZE,
+                size_t pool_size = BUFFER_POOL_SIZE,
+                size_t max_pool_size = 0, bool direct_io = false,
+                bool compress = false, bool tablespaces = false,
+                ReplacerType replacer_type = ReplacerType::LRU) {
     ENABLE_LOGGING = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    disk_manager_ = new DiskManager(db_file_name, page_size, direct_io,
+                                    compress, tablespaces);
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
     buffer_pool_manager_ =
-        new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+        new BufferPoolManager(pool_size, disk_manager_, log_manager_,
+                              replacer_type, max_pool_size);
 
     // txn related
     lock_manager_ = new LockManager(true); // S2PL
@@ -82,11 +94,13 @@ public:
   ~StorageEngine() {
     if (ENABLE_LOGGING)
       log_manager_->StopFlushThread();
-    delete disk_manager_;
+    // the pool drops dirty pages when deleted, write them out first
+    buffer_pool_manager_->FlushAllPages();
     delete buffer_pool_manager_;
-    delete log_manager_;
-    delete lock_manager_;
     delete transaction_manager_;
+    delete lock_manager_;
+    delete log_manager_;
+    delete disk_manager_;
   }
 
   DiskManager *disk_manager_;
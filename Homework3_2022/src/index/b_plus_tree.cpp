@@ -18,7 +18,12 @@ namespace scudb {
                               const KeyComparator &comparator,
                               page_id_t root_page_id) ////tree rootpage号
             : index_name_(name), root_page_id_(root_page_id),
-              buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
+              buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {
+        // new pages go in the file the tree is in
+        if (root_page_id != INVALID_PAGE_ID) {
+            extent_.SetFileOf(root_page_id);
+        }
+    }
 
 /*
  * Helper function to decide whether current b+tree is empty
@@ -95,11 +100,11 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
 
 
         page_id_t id;
-        Page *root_page = buffer_pool_manager_->NewPage(id);
+        Page *root_page = buffer_pool_manager_->NewPage(id, &extent_);
 
         auto *root = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(root_page->GetData());
 
-        root->Init(id,INVALID_PAGE_ID);
+        root->Init(id,INVALID_PAGE_ID,root_page->GetUsableSize());
         root_page_id_ = id;
         UpdateRootPageId(true);
 
@@ -153,13 +158,14 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
     template <typename N> N *BPLUSTREE_TYPE::Split(N *node, Transaction *transaction) {
 
         page_id_t new_page_id;
-        Page* const new_page = buffer_pool_manager_->NewPage(new_page_id);
+        Page* const new_page = buffer_pool_manager_->NewPage(new_page_id, &extent_);
 
         new_page->WLatch();
         transaction->AddIntoPageSet(new_page);
 
         N *new_node = reinterpret_cast<N *>(new_page->GetData());
-        new_node->Init(new_page_id, node->GetParentPageId());
+        new_node->Init(new_page_id, node->GetParentPageId(),
+                       new_page->GetUsableSize());
         node->MoveHalfTo(new_node, buffer_pool_manager_);
 
         return new_node;
@@ -181,10 +187,10 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
                                           Transaction *transaction) {
         assert(old_node != nullptr && new_node != nullptr && transaction != nullptr);
         if (old_node->IsRootPage()) {
-            Page* const new_page = buffer_pool_manager_->NewPage(root_page_id_);
+            Page* const new_page = buffer_pool_manager_->NewPage(root_page_id_, &extent_);
 
             auto *new_root = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(new_page->GetData());
-            new_root->Init(root_page_id_);
+            new_root->Init(root_page_id_,INVALID_PAGE_ID,new_page->GetUsableSize());
             new_root->PopulateNewRoot(old_node->GetPageId(),key,new_node->GetPageId());
 
             old_node->SetParentPageId(root_page_id_);
@@ -389,11 +395,11 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
  * @return : index iterator
  */
     INDEX_TEMPLATE_ARGUMENTS
-    INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
+    INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(BufferAccessStrategy *strategy) {
         KeyType unuse{};
         auto start_leaf = FindLeafPage(unuse, true);
         TryUnlockRootPageId(false);
-        return INDEXITERATOR_TYPE(start_leaf, 0, buffer_pool_manager_);
+        return INDEXITERATOR_TYPE(start_leaf, 0, buffer_pool_manager_, strategy);
     }
 
 /*
@@ -402,17 +408,18 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
  * @return : index iterator
  */
     INDEX_TEMPLATE_ARGUMENTS
-    INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
+    INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key,
+                                             BufferAccessStrategy *strategy) {
         ////寻找index
         auto start_leaf = FindLeafPage(key);
         TryUnlockRootPageId(false);
         if (start_leaf == nullptr) {
             ////没找到，则返回0
-            return INDEXITERATOR_TYPE(start_leaf, 0, buffer_pool_manager_);
+            return INDEXITERATOR_TYPE(start_leaf, 0, buffer_pool_manager_, strategy);
         }
         int idx = start_leaf->KeyIndex(key,comparator_);
         ////找到了，构造idx的index iterator
-        return INDEXITERATOR_TYPE(start_leaf, idx, buffer_pool_manager_);//return
+        return INDEXITERATOR_TYPE(start_leaf, idx, buffer_pool_manager_, strategy);//return
     }
 
 /*****************************************************************************
@@ -427,6 +434,11 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
                                                              bool leftMost, OperationType op,
                                                              Transaction *transaction) {
         bool exclusive = (op != OperationType::READ);
+        B_PLUS_TREE_LEAF_PAGE_TYPE *leaf = nullptr;
+        if (!exclusive && OptimisticFindLeafPage(key, leftMost, transaction, leaf)) {
+            return leaf;
+        }
+        ////有写者冲突，加读锁crab下去
         LockRootPageId(exclusive);
         if (IsEmpty()) {
             TryUnlockRootPageId(exclusive);
@@ -447,6 +459,89 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
         }
         return static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(pointer);
     }
+/*
+ * Read-only descent that latches nothing but the leaf: an inner page is
+ * copied and the copy used only if the page's version did not change while
+ * copying; the version is checked once more after the child is pinned, so
+ * the child was still linked from the page at that point. The leaf is left
+ * read latched and pinned (and in the transaction's page set) as
+ * CrabingProtocalFetchPage would leave it. Return false if a writer got in
+ * the way or a page could not be fetched; everything is released then and
+ * the caller crabs down with latches
+ */
+    INDEX_TEMPLATE_ARGUMENTS
+    bool BPLUSTREE_TYPE::OptimisticFindLeafPage(const KeyType &key, bool leftMost,
+                                                Transaction *transaction,
+                                                B_PLUS_TREE_LEAF_PAGE_TYPE *&leaf) {
+        leaf = nullptr;
+        ////每个线程复用同一块拷贝缓冲区
+        static thread_local std::vector<char> copy;
+        copy.resize(buffer_pool_manager_->GetPageSize());
+        LockRootPageId(false);
+        if (IsEmpty()) {
+            TryUnlockRootPageId(false);
+            return true;
+        }
+        page_id_t cur = root_page_id_;
+        Page *page = buffer_pool_manager_->FetchPage(cur);
+        if (page == nullptr) {
+            TryUnlockRootPageId(false);
+            return false;
+        }
+        uint64_t version;
+        bool valid = page->ROptimisticLatch(version);
+        TryUnlockRootPageId(false);
+        auto tree_page = reinterpret_cast<BPlusTreePage *>(page->GetData());
+        if (valid && tree_page->IsLeafPage()) {
+            page->RLatch();
+            valid = page->RValidate(version);
+            if (!valid) {
+                page->RUnlatch();
+            }
+        }
+        while (valid && !tree_page->IsLeafPage()) {
+            ////先拷贝再验证，Lookup只看一致的拷贝
+            memcpy(copy.data(), page->GetData(), copy.size());
+            if (!page->RValidate(version)) {
+                valid = false;
+                break;
+            }
+            auto *internalPage = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(copy.data());
+            page_id_t next = leftMost ? internalPage->ValueAt(0)
+                                      : internalPage->Lookup(key,comparator_);
+            Page *child = buffer_pool_manager_->FetchPage(next);
+            if (child == nullptr) {
+                valid = false;
+                break;
+            }
+            auto child_tree_page = reinterpret_cast<BPlusTreePage *>(child->GetData());
+            uint64_t child_version = 0;
+            bool child_leaf = child_tree_page->IsLeafPage();
+            if (child_leaf) {
+                child->RLatch();
+            } else {
+                valid = child->ROptimisticLatch(child_version);
+            }
+            valid = valid && page->RValidate(version);
+            if (!valid && child_leaf) {
+                child->RUnlatch();
+            }
+            buffer_pool_manager_->UnpinPage(cur,false);
+            cur = next;
+            page = child;
+            tree_page = child_tree_page;
+            version = child_version;
+        }
+        if (!valid) {
+            buffer_pool_manager_->UnpinPage(cur,false);
+            return false;
+        }
+        if (transaction != nullptr)
+            transaction->AddIntoPageSet(page);
+        leaf = static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(tree_page);
+        return true;
+    }
+
     INDEX_TEMPLATE_ARGUMENTS
     BPlusTreePage *BPLUSTREE_TYPE::FetchPage(page_id_t page_id) {
         auto page = buffer_pool_manager_->FetchPage(page_id);
@@ -523,12 +618,12 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
         }
         std::queue<BPlusTreePage *> todo, tmp;
         std::stringstream tree;
-        auto node = reinterpret_cast<BPlusTreePage *>(
-                buffer_pool_manager_->FetchPage(root_page_id_));
-        if (node == nullptr) {
+        Page *root = buffer_pool_manager_->FetchPage(root_page_id_);
+        if (root == nullptr) {
             throw Exception(EXCEPTION_TYPE_INDEX,
                             "all page are pinned while printing");
         }
+        auto node = reinterpret_cast<BPlusTreePage *>(root->GetData());
         todo.push(node);
         bool first = true;
         while (!todo.empty()) {
@@ -602,7 +697,7 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
     int BPLUSTREE_TYPE::isBalanced(page_id_t pid) {
         if (IsEmpty()) return true;
         ////通过pid获取目标page
-        auto node = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(pid));
+        auto node = FetchPage(pid);
         int ret = 0;
         if (!node->IsLeafPage())  {
             auto page = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(node);
@@ -629,10 +724,11 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
     bool BPLUSTREE_TYPE::isPageCorr(page_id_t pid,pair<KeyType,KeyType> &out) {
         if (IsEmpty()) return true;
         else{
-            auto node = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(pid));
-            if (node == nullptr) {
+            Page *raw = buffer_pool_manager_->FetchPage(pid);
+            if (raw == nullptr) {
                 throw Exception(EXCEPTION_TYPE_INDEX,"all page are pinned while isPageCorr");
             }
+            auto node = reinterpret_cast<BPlusTreePage *>(raw->GetData());
             bool ret = true;
             if (node->IsLeafPage())  {
                 auto page = reinterpret_cast<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *>(node);
@@ -13,8 +13,10 @@ namespace scudb {
  */
 
     INDEX_TEMPLATE_ARGUMENTS
-    INDEXITERATOR_TYPE::IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf, int index, BufferPoolManager *buf_pool_manager)
-            : mIndex_(index),mLeafPage_(leaf), mBufferPoolManager_(buf_pool_manager){}
+    INDEXITERATOR_TYPE::IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf, int index, BufferPoolManager *buf_pool_manager,
+                                      BufferAccessStrategy *strategy)
+            : mIndex_(index),mLeafPage_(leaf), mBufferPoolManager_(buf_pool_manager),
+              mStrategy_(strategy), mReadAhead_(buf_pool_manager, strategy){}
 
     INDEX_TEMPLATE_ARGUMENTS
     INDEXITERATOR_TYPE::~IndexIterator() {
@@ -58,7 +60,8 @@ namespace scudb {
             if (next == INVALID_PAGE_ID) {
                 mLeafPage_ = nullptr;
             } else {
-                Page *page = mBufferPoolManager_->FetchPage(next);
+                mReadAhead_.Access(next);
+                Page *page = mBufferPoolManager_->FetchPage(next, mStrategy_);
                 page->RLatch();
                 mLeafPage_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
                 mIndex_ = 0;
@@ -18,13 +18,13 @@ namespace scudb {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
-                                          page_id_t parent_id) {
+                                          page_id_t parent_id, int page_size) {
     //// 初始化类成员变量
     SetSize(0);
     SetPageId(page_id);
     SetPageType(IndexPageType::INTERNAL_PAGE);
     SetParentPageId(parent_id);
-    int size =  (PAGE_SIZE- sizeof(BPlusTreeInternalPage))/sizeof(MappingType);
+    int size =  (page_size - sizeof(BPlusTreeInternalPage))/sizeof(MappingType);
     SetMaxSize(size - 1);
 }
 /*
@@ -116,7 +116,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(
     array[1].first = new_key;
     array[1].second = new_value;
 
-    IncreaseSize(1);
+    SetSize(2);
 }
 /*
  * Insert new_key & new_value pair right after the pair with its value ==
@@ -21,7 +21,8 @@ namespace scudb {
  * next page id and set max size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id,
+                                      int page_size) {
     SetPageType(IndexPageType::LEAF_PAGE);////叶子节点
 
     ////初始化
@@ -31,7 +32,7 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id) {
     assert(sizeof(BPlusTreeLeafPage) == 28);
     SetPageId(page_id);
     SetNextPageId(INVALID_PAGE_ID);
-    int max_size = (PAGE_SIZE - sizeof(BPlusTreeLeafPage))/sizeof(MappingType);
+    int max_size = (page_size - sizeof(BPlusTreeLeafPage))/sizeof(MappingType);
     SetMaxSize(max_size - 1);
 }
 
@@ -17,10 +17,13 @@ bool HeaderPage::InsertRecord(const std::string &name,
   assert(root_id > INVALID_PAGE_ID);
 
   int record_num = GetRecordCount();
-  int offset = 4 + record_num * 36;
+  int offset = PREFIX_SIZE + record_num * 36;
   // check for duplicate name
   if (FindRecord(name) != -1)
     return false;
+  // no room for another entry
+  if (record_num >= GetMaxRecordCount())
+    return false;
   // copy record content
   memcpy(GetData() + offset, name.c_str(), (name.length() + 1));
   memcpy((GetData() + offset + 32), &root_id, 4);
@@ -37,7 +40,7 @@ bool HeaderPage::DeleteRecord(const std::string &name) {
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = index * 36 + 4;
+  int offset = index * 36 + PREFIX_SIZE;
   memmove(GetData() + offset, GetData() + offset + 36,
           (record_num - index - 1) * 36);
 
@@ -53,7 +56,7 @@ bool HeaderPage::UpdateRecord(const std::string &name,
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = index * 36 + 4;
+  int offset = index * 36 + PREFIX_SIZE;
   // update record content, only root_id
   memcpy((GetData() + offset + 32), &root_id, 4);
 
@@ -67,7 +70,7 @@ bool HeaderPage::GetRootId(const std::string &name, page_id_t &root_id) {
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = (index + 1) * 36;
+  int offset = PREFIX_SIZE + index * 36 + 32;
   root_id = *reinterpret_cast<page_id_t *>(GetData() + offset);
 
   return true;
@@ -83,11 +86,50 @@ void HeaderPage::SetRecordCount(int record_count) {
   memcpy(GetData(), &record_count, 4);
 }
 
+int HeaderPage::GetMaxRecordCount() {
+  return (static_cast<int>(GetUsableSize()) - PREFIX_SIZE) / 36;
+}
+
+// page size
+size_t HeaderPage::StoredPageSize(const char *data) {
+  uint32_t page_size;
+  memcpy(&page_size, data + 4, 4);
+  return page_size;
+}
+
+void HeaderPage::SetStoredPageSize(size_t page_size) {
+  StorePageSize(GetData(), page_size);
+}
+
+void HeaderPage::StorePageSize(char *data, size_t page_size) {
+  uint32_t stored = static_cast<uint32_t>(page_size);
+  memcpy(data + 4, &stored, 4);
+}
+
+// free space, kept by the disk manager
+page_id_t HeaderPage::StoredFreeListHead(const char *data) {
+  page_id_t free_list_head;
+  memcpy(&free_list_head, data + 8, 4);
+  return free_list_head;
+}
+
+page_id_t HeaderPage::StoredNumPages(const char *data) {
+  page_id_t num_pages;
+  memcpy(&num_pages, data + 12, 4);
+  return num_pages;
+}
+
+void HeaderPage::StoreFreeSpace(char *data, page_id_t free_list_head,
+                                page_id_t num_pages) {
+  memcpy(data + 8, &free_list_head, 4);
+  memcpy(data + 12, &num_pages, 4);
+}
+
 int HeaderPage::FindRecord(const std::string &name) {
   int record_num = GetRecordCount();
 
   for (int i = 0; i < record_num; i++) {
-    char *raw_name = reinterpret_cast<char *>(GetData() + (4 + i * 36));
+    char *raw_name = reinterpret_cast<char *>(GetData() + (PREFIX_SIZE + i * 36));
     if (strcmp(raw_name, name.c_str()) == 0)
       return i;
   }
@@ -14,7 +14,10 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager,
                      LockManager *lock_manager, LogManager *log_manager,
                      page_id_t first_page_id)
     : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager),
-      log_manager_(log_manager), first_page_id_(first_page_id) {}
+      log_manager_(log_manager), first_page_id_(first_page_id) {
+  // new pages go in the file the table is in
+  extent_.SetFileOf(first_page_id);
+}
 
 // create table
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager,
@@ -23,18 +26,21 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager,
     : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager),
       log_manager_(log_manager) {
   auto first_page =
-      static_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_));
+      static_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_,
+                                                             &extent_));
   assert(first_page != nullptr); // todo: abort table creation?
   first_page->WLatch();
   LOG_DEBUG("new table page created %d", first_page_id_);
 
-  first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
+  first_page->Init(first_page_id_, first_page->GetUsableSize(), INVALID_LSN, log_manager_, txn);
   first_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, true);
 }
 
 bool TableHeap::InsertTuple(const Tuple &tuple, RID &rid, Transaction *txn) {
-  if (tuple.size_ + 32 > PAGE_SIZE) { // larger than one page size
+  // larger than one page size
+  if (tuple.size_ + 32 > static_cast<int32_t>(buffer_pool_manager_->GetPageSize() -
+                                               PAGE_CHECKSUM_SIZE)) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
@@ -59,7 +65,8 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID &rid, Transaction *txn) {
       cur_page->WLatch();
     } else { // create new page
       auto new_page =
-          static_cast<TablePage *>(buffer_pool_manager_->NewPage(next_page_id));
+          static_cast<TablePage *>(buffer_pool_manager_->NewPage(next_page_id,
+                                                                 &extent_));
       if (new_page == nullptr) {
         cur_page->WUnlatch();
         buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), false);
@@ -70,7 +77,7 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID &rid, Transaction *txn) {
       // std::cout << "new table page " << next_page_id << " created" <<
       // std::endl;
       cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetPageId(),
+      new_page->Init(next_page_id, new_page->GetUsableSize(), cur_page->GetPageId(),
                      log_manager_, txn);
       cur_page->WUnlatch();
       buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), true);
@@ -140,9 +147,10 @@ void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
 }
 
 // called by tuple iterator
-bool TableHeap::GetTuple(const RID &rid, Tuple &tuple, Transaction *txn) {
+bool TableHeap::GetTuple(const RID &rid, Tuple &tuple, Transaction *txn,
+                         BufferAccessStrategy *strategy) {
   auto page = static_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
+      buffer_pool_manager_->FetchPage(rid.GetPageId(), strategy));
   if (page == nullptr) {
     txn->SetState(TransactionState::ABORTED);
     return false;
@@ -159,9 +167,10 @@ bool TableHeap::DeleteTableHeap() {
   return true;
 }
 
-TableIterator TableHeap::begin(Transaction *txn) {
-  auto page =
-      static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+TableIterator TableHeap::begin(Transaction *txn,
+                               BufferAccessStrategy *strategy) {
+  auto page = static_cast<TablePage *>(
+      buffer_pool_manager_->FetchPage(first_page_id_, strategy));
   page->RLatch();
   RID rid;
   // if failed (no tuple), rid will be the result of default
@@ -169,7 +178,7 @@ TableIterator TableHeap::begin(Transaction *txn) {
   page->GetFirstTupleRid(rid);
   page->RUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, false);
-  return TableIterator(this, rid, txn);
+  return TableIterator(this, rid, txn, strategy);
 }
 
 TableIterator TableHeap::end() {
@@ -2,8 +2,10 @@
  * virtual_table.cpp
  */
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <strings.h>
 #include <sys/stat.h>
 #include <vector>
 
@@ -348,6 +350,162 @@ sqlite3_module VtableModule = {
     0,              /* xRollbackTo */
 };
 
+/*
+** bpm_stats: read-only, eponymous table of the buffer pool counters, one
+** (name, value) row per counter, e.g. SELECT * FROM bpm_stats;
+*/
+struct StatsCursor {
+  sqlite3_vtab_cursor base_;
+  std::vector<std::pair<std::string, sqlite3_int64>> rows_;
+  size_t current_ = 0;
+};
+
+static int StatsConnect(sqlite3 *db, void *pAux, int argc,
+                        const char *const *argv, sqlite3_vtab **ppVtab,
+                        char **pzErr) {
+  int rc = sqlite3_declare_vtab(db, "CREATE TABLE X(name TEXT, value INTEGER)");
+  if (rc != SQLITE_OK)
+    return rc;
+  *ppVtab = new sqlite3_vtab();
+  return SQLITE_OK;
+}
+
+static int StatsDisconnect(sqlite3_vtab *pVtab) {
+  delete pVtab;
+  return SQLITE_OK;
+}
+
+static int StatsBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
+  // a handful of rows, always a full scan
+  pIdxInfo->estimatedCost = 10;
+  return SQLITE_OK;
+}
+
+static int StatsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
+  *ppCursor = reinterpret_cast<sqlite3_vtab_cursor *>(new StatsCursor());
+  return SQLITE_OK;
+}
+
+static int StatsClose(sqlite3_vtab_cursor *cur) {
+  delete reinterpret_cast<StatsCursor *>(cur);
+  return SQLITE_OK;
+}
+
+// take the snapshot the scan returns
+static int StatsFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum,
+                       const char *idxStr, int argc, sqlite3_value **argv) {
+  StatsCursor *cursor = reinterpret_cast<StatsCursor *>(pVtabCursor);
+  BufferPoolStats stats = storage_engine_->buffer_pool_manager_->GetStats();
+  cursor->rows_ = {
+      {"hits", stats.hits},
+      {"misses", stats.misses},
+      {"evictions", stats.evictions},
+      {"write_backs", stats.write_backs},
+      {"sync_writes", stats.sync_writes},
+      {"cleaner_writes", stats.cleaner_writes},
+      {"new_pages", stats.new_pages},
+      {"delete_pages", stats.delete_pages},
+      {"prefetches", stats.prefetches},
+      {"ring_reuses", stats.ring_reuses},
+      {"read_failures", stats.read_failures},
+      {"latch_waits", stats.latch_waits},
+      {"latch_wait_ns", stats.latch_wait_ns},
+      {"pool_size", stats.pool_size},
+      {"arc_target_size", stats.arc_target_size},
+      {"frames_pinned_0", stats.pinned_frames[0]},
+      {"frames_pinned_1", stats.pinned_frames[1]},
+      {"frames_pinned_2_3", stats.pinned_frames[2]},
+      {"frames_pinned_4_7", stats.pinned_frames[3]},
+      {"frames_pinned_8_up", stats.pinned_frames[4]},
+  };
+  cursor->current_ = 0;
+  return SQLITE_OK;
+}
+
+static int StatsNext(sqlite3_vtab_cursor *cur) {
+  reinterpret_cast<StatsCursor *>(cur)->current_++;
+  return SQLITE_OK;
+}
+
+static int StatsEof(sqlite3_vtab_cursor *cur) {
+  StatsCursor *cursor = reinterpret_cast<StatsCursor *>(cur);
+  return cursor->current_ >= cursor->rows_.size();
+}
+
+static int StatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i) {
+  StatsCursor *cursor = reinterpret_cast<StatsCursor *>(cur);
+  auto &row = cursor->rows_[cursor->current_];
+  if (i == 0) {
+    sqlite3_result_text(ctx, row.first.c_str(), -1, SQLITE_TRANSIENT);
+  } else {
+    sqlite3_result_int64(ctx, row.second);
+  }
+  return SQLITE_OK;
+}
+
+static int StatsRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid) {
+  *pRowid = reinterpret_cast<StatsCursor *>(cur)->current_;
+  return SQLITE_OK;
+}
+
+sqlite3_module StatsModule = {
+    0,               /* iVersion */
+    0,               /* xCreate - eponymous only */
+    StatsConnect,    /* xConnect */
+    StatsBestIndex,  /* xBestIndex */
+    StatsDisconnect, /* xDisconnect */
+    0,               /* xDestroy */
+    StatsOpen,       /* xOpen - open a cursor */
+    StatsClose,      /* xClose - close a cursor */
+    StatsFilter,     /* xFilter - configure scan constraints */
+    StatsNext,       /* xNext - advance a cursor */
+    StatsEof,        /* xEof - check for end of scan */
+    StatsColumn,     /* xColumn - read data */
+    StatsRowid,      /* xRowid - read data */
+    0,               /* xUpdate - read-only */
+    0,               /* xBegin */
+    0,               /* xSync */
+    0,               /* xCommit */
+    0,               /* xRollback */
+    0,               /* xFindMethod */
+    0,               /* xRename */
+    0,               /* xSavepoint */
+    0,               /* xRelease */
+    0,               /* xRollbackTo */
+};
+
+// bpm_resize(n): resize the buffer pool to n frames, return the frames it
+// ended up with (fewer than asked past the maximum, more if too many are
+// pinned to shrink that far)
+static void ResizeFunc(sqlite3_context *ctx, int, sqlite3_value **argv) {
+  sqlite3_int64 pool_size = sqlite3_value_int64(argv[0]);
+  if (pool_size < 0) {
+    sqlite3_result_error(ctx, "bpm_resize takes a number of frames", -1);
+    return;
+  }
+  sqlite3_result_int64(ctx, storage_engine_->buffer_pool_manager_->Resize(
+                                static_cast<size_t>(pool_size)));
+}
+
+// SCUDB_REPLACER names the replacement policy: lru (the default), clock,
+// lru_k or arc, in any case
+static ReplacerType ParseReplacerType(const char *name) {
+  if (name == nullptr || strcasecmp(name, "lru") == 0) {
+    return ReplacerType::LRU;
+  }
+  if (strcasecmp(name, "clock") == 0) {
+    return ReplacerType::CLOCK;
+  }
+  if (strcasecmp(name, "lru_k") == 0) {
+    return ReplacerType::LRU_K;
+  }
+  if (strcasecmp(name, "arc") == 0) {
+    return ReplacerType::ARC;
+  }
+  LOG_DEBUG("unknown SCUDB_REPLACER %s, using lru", name);
+  return ReplacerType::LRU;
+}
+
 #ifdef _WIN32
 __declspec(dllexport)
 #endif
@@ -358,20 +516,53 @@ __declspec(dllexport)
   struct stat buffer;
   bool is_file_exist = (stat(db_file_name.c_str(), &buffer) == 0);
 
-  // init storage engine
-  storage_engine_ = new StorageEngine(db_file_name);
+  // init storage engine, SCUDB_PAGE_SIZE, SCUDB_POOL_SIZE and
+  // SCUDB_MAX_POOL_SIZE override the defaults (the page size only for a new
+  // db file); SCUDB_DIRECT_IO=1 opens the db file with O_DIRECT,
+  // SCUDB_COMPRESS=1 makes a new db file compressed, SCUDB_TABLESPACES=1
+  // puts every new table and index in a file of its own and SCUDB_REPLACER
+  // picks the replacement policy
+  const char *page_size = getenv("SCUDB_PAGE_SIZE");
+  const char *pool_size = getenv("SCUDB_POOL_SIZE");
+  const char *max_pool_size = getenv("SCUDB_MAX_POOL_SIZE");
+  const char *direct_io = getenv("SCUDB_DIRECT_IO");
+  const char *compress = getenv("SCUDB_COMPRESS");
+  const char *tablespaces = getenv("SCUDB_TABLESPACES");
+  const char *replacer = getenv("SCUDB_REPLACER");
+  try {
+    storage_engine_ = new StorageEngine(
+        db_file_name, page_size ? strtoul(page_size, nullptr, 10) : PAGE_SIZE,
+        pool_size ? strtoul(pool_size, nullptr, 10) : BUFFER_POOL_SIZE,
+        max_pool_size ? strtoul(max_pool_size, nullptr, 10) : 0,
+        direct_io != nullptr && strcmp(direct_io, "1") == 0,
+        compress != nullptr && strcmp(compress, "1") == 0,
+        tablespaces != nullptr && strcmp(tablespaces, "1") == 0,
+        ParseReplacerType(replacer));
+  } catch (Exception &e) {
+    // a page size out of range, or a db file of an older format
+    *pzErrMsg = sqlite3_mprintf("%s", e.what());
+    return SQLITE_ERROR;
+  }
   // start the logging
   storage_engine_->log_manager_->RunFlushThread();
   // create header page from BufferPoolManager if necessary
   if (!is_file_exist) {
     page_id_t header_page_id;
-    storage_engine_->buffer_pool_manager_->NewPage(header_page_id);
+    HeaderPage *header_page = static_cast<HeaderPage *>(
+        storage_engine_->buffer_pool_manager_->NewPage(header_page_id));
 
     assert(header_page_id == HEADER_PAGE_ID);
+    // records the page size for the next time the file is opened
+    header_page->Init();
     storage_engine_->buffer_pool_manager_->UnpinPage(header_page_id, true);
   }
 
   int rc = sqlite3_create_module(db, "vtable", &VtableModule, nullptr);
+  if (rc == SQLITE_OK)
+    rc = sqlite3_create_module(db, "bpm_stats", &StatsModule, nullptr);
+  if (rc == SQLITE_OK)
+    rc = sqlite3_create_function(db, "bpm_resize", 1, SQLITE_UTF8, nullptr,
+                                 ResizeFunc, nullptr, nullptr);
   return rc;
 }
 
@@ -0,0 +1,161 @@
+/**
+ * arc_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+    TEST(ARCReplacerTest, SampleTest) {
+        ARCReplacer<int> arc_replacer(3, 0);
+        int value;
+
+        EXPECT_EQ(false, arc_replacer.Victim(value));
+
+        // 2 is seen twice and moves to T2, 1 and 3 stay in T1
+        arc_replacer.Insert(1);
+        arc_replacer.Insert(2);
+        arc_replacer.Insert(3);
+        arc_replacer.Insert(2);
+        EXPECT_EQ(3, arc_replacer.Size());
+        EXPECT_EQ(0, arc_replacer.GetTargetSize());
+
+        // T1 is above its target, evict from it in LRU order
+        EXPECT_EQ(true, arc_replacer.Victim(value));
+        EXPECT_EQ(1, value);
+        EXPECT_EQ(true, arc_replacer.Victim(value));
+        EXPECT_EQ(3, value);
+
+        // 1 comes back while still remembered in B1: T1 should grow
+        arc_replacer.Insert(1);
+        EXPECT_EQ(1, arc_replacer.GetTargetSize());
+
+        // pinning keeps the frame resident but not evictable
+        EXPECT_EQ(true, arc_replacer.Erase(2));
+        EXPECT_EQ(false, arc_replacer.Erase(2));
+        EXPECT_EQ(1, arc_replacer.Size());
+        EXPECT_EQ(true, arc_replacer.Victim(value));
+        EXPECT_EQ(1, value);
+        EXPECT_EQ(false, arc_replacer.Victim(value));
+
+        // 1 comes back from B2: T2 should grow again
+        arc_replacer.Insert(1);
+        EXPECT_EQ(0, arc_replacer.GetTargetSize());
+        arc_replacer.Insert(2);
+        EXPECT_EQ(2, arc_replacer.Size());
+    }
+
+    TEST(ARCReplacerTest, ForgetTest) {
+        ARCReplacer<int> arc_replacer(4, 0);
+        int value;
+
+        // 2 and 1 are seen twice; 1 is pinned and then its frame is freed
+        arc_replacer.Insert(2);
+        arc_replacer.Insert(2);
+        arc_replacer.Insert(1);
+        arc_replacer.Insert(1);
+        arc_replacer.Erase(1);
+        arc_replacer.Forget(1);
+        EXPECT_EQ(1, arc_replacer.Size());
+
+        // the frame's next page is new: it goes to T1, and without a ghost
+        arc_replacer.Insert(1);
+        EXPECT_EQ(0, arc_replacer.GetTargetSize());
+        EXPECT_EQ(true, arc_replacer.Victim(value));
+        EXPECT_EQ(1, value);
+        EXPECT_EQ(true, arc_replacer.Victim(value));
+        EXPECT_EQ(2, value);
+    }
+
+    TEST(ARCReplacerTest, CorrelatedReferenceTest) {
+        ARCReplacer<int> arc_replacer(4, 1);
+        int value;
+
+        // back-to-back references to 1 do not promote it to T2
+        arc_replacer.Insert(2);
+        arc_replacer.Insert(1);
+        arc_replacer.Insert(1);
+        arc_replacer.Insert(3);
+        arc_replacer.Insert(2);
+        EXPECT_EQ(true, arc_replacer.Victim(value));
+        EXPECT_EQ(1, value);
+        EXPECT_EQ(true, arc_replacer.Victim(value));
+        EXPECT_EQ(3, value);
+        EXPECT_EQ(true, arc_replacer.Victim(value));
+        EXPECT_EQ(2, value);
+    }
+
+    // OLTP (random lookups on a hot set), a scan over many cold pages, OLTP on a
+    // hot set that moved elsewhere, then back to the first one; the same trace
+    // is replayed for every policy
+    static BufferPoolStats ReplayTrace(ReplacerType replacer_type,
+                                       size_t &max_target) {
+        const int pool_size = 32;
+        const int num_pages = 256;
+        const int hot_pages = 24;
+        DiskManager *disk_manager = new DiskManager("test.db");
+        BufferPoolManager *bpm =
+                new BufferPoolManager(pool_size, disk_manager, nullptr, replacer_type);
+
+        page_id_t page_id;
+        for (int i = 0; i < num_pages; ++i) {
+            EXPECT_NE(nullptr, bpm->NewPage(page_id));
+            EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+        }
+
+        std::mt19937 rng(42);
+        max_target = 0;
+        auto fetch = [&](page_id_t id) {
+            Page *page = bpm->FetchPage(id);
+            EXPECT_NE(nullptr, page);
+            bpm->UnpinPage(id, false);
+            max_target = std::max(max_target, bpm->GetStats().arc_target_size);
+        };
+        auto oltp = [&](page_id_t first) {
+            for (int i = 0; i < 2000; ++i) {
+                fetch(first + rng() % hot_pages);
+            }
+        };
+        oltp(0);
+        for (page_id_t id = hot_pages; id < num_pages; ++id) {
+            fetch(id);
+        }
+        oltp(num_pages / 2);
+        oltp(0);
+
+        BufferPoolStats stats = bpm->GetStats();
+        delete bpm;
+        delete disk_manager;
+        remove("test.db");
+        return stats;
+    }
+
+    TEST(ARCReplacerTest, TraceTest) {
+        const ReplacerType types[] = {ReplacerType::LRU, ReplacerType::CLOCK,
+                                      ReplacerType::LRU_K, ReplacerType::ARC};
+        const char *names[] = {"LRU", "CLOCK", "LRU-K", "ARC"};
+        BufferPoolStats stats[4];
+        size_t max_target[4];
+        for (int i = 0; i < 4; ++i) {
+            stats[i] = ReplayTrace(types[i], max_target[i]);
+            printf("%-6s hits %5zu misses %5zu hit rate %.3f max ARC target %zu\n",
+                   names[i], stats[i].hits, stats[i].misses,
+                   stats[i].hits / double(stats[i].hits + stats[i].misses),
+                   max_target[i]);
+        }
+
+        // only ARC reports a target, and it grew when the hot set moved
+        EXPECT_EQ(0, max_target[0]);
+        EXPECT_LT(0, max_target[3]);
+        // LRU-K is slow to let go of the old hot set, ARC follows the shift and
+        // stays close to LRU
+        EXPECT_LT(stats[2].hits, stats[3].hits);
+        EXPECT_LE(stats[0].hits * 0.98, stats[3].hits);
+    }
+
+} // namespace scudb
@@ -0,0 +1,149 @@
+/**
+ * buffer_access_strategy_test.cpp
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+#include "buffer/buffer_pool_manager.h"
+#include "logging/common.h"
+#include "table/table_heap.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+    TEST(BufferAccessStrategyTest, RingTest) {
+        page_id_t temp_page_id;
+
+        DiskManager *disk_manager = new DiskManager("test.db");
+        BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+        for (int i = 0; i < 30; ++i) {
+            EXPECT_NE(nullptr, bpm->NewPage(temp_page_id));
+            EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+        }
+        // pages 0-5 are hot
+        for (page_id_t page_id = 0; page_id < 6; ++page_id) {
+            EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+            EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+        }
+
+        // a scan of the other pages through a ring of 2 frames
+        BufferAccessStrategy strategy(2);
+        for (page_id_t page_id = 6; page_id < 30; ++page_id) {
+            EXPECT_NE(nullptr, bpm->FetchPage(page_id, &strategy));
+            EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+        }
+        // 26 and 27 were still cached but the ring took their frames first
+        EXPECT_EQ(22, strategy.GetMisses());
+        EXPECT_EQ(20, bpm->GetStats().ring_reuses);
+
+        // the hot pages are all still there
+        int reads = disk_manager->GetNumReads();
+        for (page_id_t page_id = 0; page_id < 6; ++page_id) {
+            EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+            EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+        }
+        EXPECT_EQ(reads, disk_manager->GetNumReads());
+
+        // the ring holds 26 and 27 now; a ring frame somebody else pinned is
+        // left alone, so 6 goes to the LRU frame, which is 27's
+        EXPECT_NE(nullptr, bpm->FetchPage(26));
+        EXPECT_NE(nullptr, bpm->FetchPage(6, &strategy));
+        EXPECT_EQ(true, bpm->UnpinPage(6, false));
+        EXPECT_EQ(20, bpm->GetStats().ring_reuses);
+        // and the slot of 27 no longer holds the ring's page
+        EXPECT_NE(nullptr, bpm->FetchPage(7, &strategy));
+        EXPECT_EQ(true, bpm->UnpinPage(7, false));
+        EXPECT_EQ(20, bpm->GetStats().ring_reuses);
+        EXPECT_NE(nullptr, bpm->FetchPage(8, &strategy));
+        EXPECT_EQ(true, bpm->UnpinPage(8, false));
+        EXPECT_EQ(21, bpm->GetStats().ring_reuses);
+        EXPECT_EQ(true, bpm->UnpinPage(26, false));
+
+        delete bpm;
+        delete disk_manager;
+        remove("test.db");
+    }
+
+    // hit rate of random point lookups on a few table pages while another
+    // thread scans the whole table over and over, with the given ring size
+    static double LookupHitRateDuringScan(size_t ring_size, size_t &misses) {
+        Schema *schema = ParseCreateStatement("a varchar, b smallint, c bigint");
+        Transaction *transaction = new Transaction(0);
+        DiskManager *disk_manager = new DiskManager("test.db");
+        BufferPoolManager *bpm = new BufferPoolManager(32, disk_manager);
+        LockManager *lock_manager = new LockManager(true);
+        LogManager *log_manager = new LogManager(disk_manager);
+
+        TableHeap *table = new TableHeap(bpm, lock_manager, log_manager, transaction);
+        Tuple tuple = ConstructTuple(schema);
+        RID rid;
+        for (int i = 0; i < 3000; ++i) {
+            table->InsertTuple(tuple, rid, transaction);
+        }
+        page_id_t first_page_id = table->GetFirstPageId();
+        const int hot_pages = 12;
+
+        BufferAccessStrategy strategy(ring_size);
+        std::atomic<bool> scanning(true);
+        std::thread scanner([&] {
+            for (int round = 0; round < 20; ++round) {
+                int scanned = 0;
+                for (auto itr = table->begin(transaction, &strategy);
+                     itr != table->end(); ++itr) {
+                    scanned++;
+                }
+                EXPECT_EQ(3000, scanned);
+            }
+            scanning = false;
+        });
+
+        std::mt19937 rng(0);
+        size_t lookups = 0;
+        BufferPoolStats before = bpm->GetStats();
+        size_t scan_fetches = strategy.GetHits() + strategy.GetMisses();
+        size_t scan_hits = strategy.GetHits();
+        while (scanning) {
+            page_id_t page_id = first_page_id + rng() % hot_pages;
+            Page *page = bpm->FetchPage(page_id);
+            if (page != nullptr) {
+                bpm->UnpinPage(page_id, false);
+                lookups++;
+            }
+        }
+        scanner.join();
+        BufferPoolStats after = bpm->GetStats();
+        scan_fetches = strategy.GetHits() + strategy.GetMisses() - scan_fetches;
+        scan_hits = strategy.GetHits() - scan_hits;
+        size_t lookup_hits = after.hits - before.hits - scan_hits;
+        size_t lookup_fetches =
+                after.hits + after.misses - before.hits - before.misses - scan_fetches;
+        EXPECT_EQ(lookups, lookup_fetches);
+        misses = lookup_fetches - lookup_hits;
+
+        delete table;
+        delete bpm;
+        delete log_manager;
+        delete lock_manager;
+        delete disk_manager;
+        delete transaction;
+        delete schema;
+        remove("test.db");
+        remove("test.log");
+        return lookup_fetches == 0 ? 1.0 : lookup_hits / double(lookup_fetches);
+    }
+
+    TEST(BufferAccessStrategyTest, ConcurrentScanBenchmark) {
+        size_t shared_misses, ring_misses;
+        double shared = LookupHitRateDuringScan(0, shared_misses);
+        double ring = LookupHitRateDuringScan(8, ring_misses);
+        printf("point lookups during scans: shared pool hit rate %.4f (%zu misses), "
+               "8-frame ring hit rate %.4f (%zu misses)\n",
+               shared, shared_misses, ring, ring_misses);
+        EXPECT_LE(shared, ring);
+    }
+
+} // namespace scudb
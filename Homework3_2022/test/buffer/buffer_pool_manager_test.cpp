@@ -2,7 +2,13 @@
  * buffer_pool_manager_test.cpp
  */
 
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
@@ -98,5 +104,605 @@ namespace scudb {
         remove("test.db");
     }
 
+    TEST(BufferPoolManagerTest, ClockReplacerTest) {
+        page_id_t temp_page_id;
+
+        DiskManager *disk_manager = new DiskManager("test.db");
+        BufferPoolManager bpm(10, disk_manager, nullptr, ReplacerType::CLOCK);
+
+        auto page_zero = bpm.NewPage(temp_page_id);
+        ASSERT_NE(nullptr, page_zero);
+        EXPECT_EQ(0, temp_page_id);
+        strcpy(page_zero->GetData(), "Hello");
+
+        for (int i = 1; i < 10; ++i) {
+            EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+        }
+        // all the pages are pinned, the buffer pool is full
+        EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+        // unpin the first five pages, page one is touched again afterwards
+        for (int i = 0; i < 5; ++i) {
+            EXPECT_EQ(true, bpm.UnpinPage(i, true));
+        }
+        EXPECT_NE(nullptr, bpm.FetchPage(1));
+        for (int i = 10; i < 14; ++i) {
+            EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+        }
+        // only page one is left pinned among the first five
+        EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+        // fetch page zero again
+        page_zero = bpm.FetchPage(0);
+        EXPECT_EQ(nullptr, page_zero);
+        EXPECT_EQ(true, bpm.UnpinPage(1, false));
+        page_zero = bpm.FetchPage(0);
+        ASSERT_NE(nullptr, page_zero);
+        EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
+
+        remove("test.db");
+    }
+
+    TEST(BufferPoolManagerTest, PageCleanerTest) {
+        page_id_t temp_page_id;
+
+        DiskManager *disk_manager = new DiskManager("test.db");
+        BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+        bpm->RunCleanerThread(4);
+
+        // fill the pool with dirty unpinned pages
+        for (int i = 0; i < 10; ++i) {
+            Page *page = bpm->NewPage(temp_page_id);
+            ASSERT_NE(nullptr, page);
+            sprintf(page->GetData(), "page %d", i);
+            EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+        }
+        // the four pages closest to eviction get written in the background
+        for (int i = 0; i < 200 && bpm->GetStats().cleaner_writes < 4; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        EXPECT_EQ(4, bpm->GetStats().cleaner_writes);
+
+        // so these evictions do not write anything
+        for (int i = 10; i < 14; ++i) {
+            EXPECT_NE(nullptr, bpm->NewPage(temp_page_id));
+        }
+        EXPECT_EQ(0, bpm->GetStats().sync_writes);
+        for (int i = 10; i < 14; ++i) {
+            EXPECT_EQ(true, bpm->UnpinPage(i, false));
+        }
+
+        // evicted pages come back with their content
+        char expected[PAGE_SIZE];
+        for (int i = 0; i < 10; ++i) {
+            Page *page = bpm->FetchPage(i);
+            ASSERT_NE(nullptr, page);
+            sprintf(expected, "page %d", i);
+            EXPECT_EQ(0, strcmp(page->GetData(), expected));
+            EXPECT_EQ(true, bpm->UnpinPage(i, false));
+        }
+
+        bpm->StopCleanerThread();
+        delete bpm;
+        delete disk_manager;
+        remove("test.db");
+    }
+
+    TEST(BufferPoolManagerTest, PageCleanerConcurrentTest) {
+        const int num_threads = 4;
+        const int num_pages = 64;
+        const int num_updates = 2000;
+        page_id_t temp_page_id;
+
+        DiskManager *disk_manager = new DiskManager("test.db");
+        BufferPoolManager *bpm = new BufferPoolManager(8, disk_manager);
+        for (int i = 0; i < num_pages; ++i) {
+            ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+            EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+        }
+        bpm->RunCleanerThread(4);
+
+        // every thread bumps a counter on random pages; an update is lost if
+        // a page is read back before the cleaner finished writing it
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t] {
+                std::mt19937 rng(t);
+                for (int i = 0; i < num_updates; ++i) {
+                    page_id_t page_id = rng() % num_pages;
+                    Page *page = bpm->FetchPage(page_id);
+                    while (page == nullptr) {
+                        std::this_thread::yield();
+                        page = bpm->FetchPage(page_id);
+                    }
+                    page->WLatch();
+                    (*reinterpret_cast<int *>(page->GetData()))++;
+                    page->WUnlatch();
+                    bpm->UnpinPage(page_id, true);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        bpm->StopCleanerThread();
+
+        int total = 0;
+        for (int i = 0; i < num_pages; ++i) {
+            Page *page = bpm->FetchPage(i);
+            ASSERT_NE(nullptr, page);
+            total += *reinterpret_cast<int *>(page->GetData());
+            bpm->UnpinPage(i, false);
+        }
+        EXPECT_EQ(num_threads * num_updates, total);
+        BufferPoolStats stats = bpm->GetStats();
+        printf("cleaner writes %zu, synchronous writes %zu\n",
+               stats.cleaner_writes, stats.sync_writes);
+        EXPECT_LT(0, stats.cleaner_writes);
+
+        delete bpm;
+        delete disk_manager;
+        remove("test.db");
+    }
+
+    TEST(BufferPoolManagerTest, ConcurrentHitMissTest) {
+        const int num_threads = 8;
+        const int num_pages = 64;
+        const int hot_pages = 6;
+        const int num_fetches = 2000;
+        page_id_t temp_page_id;
+
+        DiskManager *disk_manager = new DiskManager("test.db");
+        BufferPoolManager *bpm = new BufferPoolManager(16, disk_manager);
+        for (int i = 0; i < num_pages; ++i) {
+            Page *page = bpm->NewPage(temp_page_id);
+            ASSERT_NE(nullptr, page);
+            *reinterpret_cast<int *>(page->GetData()) = temp_page_id;
+            EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+        }
+
+        // even threads stay on a few hot pages, odd threads read all over the
+        // file; every fetch checks that the frame holds the page asked for
+        // (a loading frame must not be handed out early) and bumps a counter
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t] {
+                std::mt19937 rng(t);
+                int range = t % 2 == 0 ? hot_pages : num_pages;
+                for (int i = 0; i < num_fetches; ++i) {
+                    page_id_t page_id = rng() % range;
+                    Page *page = bpm->FetchPage(page_id);
+                    while (page == nullptr) {
+                        std::this_thread::yield();
+                        page = bpm->FetchPage(page_id);
+                    }
+                    page->WLatch();
+                    int *data = reinterpret_cast<int *>(page->GetData());
+                    EXPECT_EQ(page_id, data[0]);
+                    data[1]++;
+                    page->WUnlatch();
+                    bpm->UnpinPage(page_id, true);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        int total = 0;
+        for (int i = 0; i < num_pages; ++i) {
+            Page *page = bpm->FetchPage(i);
+            ASSERT_NE(nullptr, page);
+            total += reinterpret_cast<int *>(page->GetData())[1];
+            bpm->UnpinPage(i, false);
+        }
+        EXPECT_EQ(num_threads * num_fetches, total);
+        BufferPoolStats stats = bpm->GetStats();
+        EXPECT_LT(0, stats.hits);
+        EXPECT_LT(0, stats.misses);
+
+        delete bpm;
+        delete disk_manager;
+        remove("test.db");
+    }
+
+    // a checkpoint writes every dirty page, pinned or not, and only those
+    TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+        page_id_t temp_page_id;
+        DiskManager *disk_manager = new DiskManager("test.db");
+        BufferPoolManager bpm(10, disk_manager);
+
+        for (int i = 0; i < 10; ++i) {
+            Page *page = bpm.NewPage(temp_page_id);
+            ASSERT_NE(nullptr, page);
+            snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+        }
+        // page 5 is clean, pages 6 and up are dirty but stay pinned
+        for (int i = 0; i < 6; ++i) {
+            EXPECT_EQ(true, bpm.UnpinPage(i, i != 5));
+        }
+        for (int i = 6; i < 10; ++i) {
+            EXPECT_NE(nullptr, bpm.FetchPage(i));
+            EXPECT_EQ(true, bpm.UnpinPage(i, true));
+        }
+        bpm.FlushAllPages();
+        EXPECT_EQ(9, bpm.GetStats().write_backs);
+        bpm.FlushAllPages();
+        EXPECT_EQ(9, bpm.GetStats().write_backs);
+
+        char data[PAGE_SIZE];
+        char expected[16];
+        for (int i = 0; i < 10; ++i) {
+            if (i == 5) {
+                continue;
+            }
+            disk_manager->ReadPage(i, data);
+            snprintf(expected, sizeof(expected), "page %d", i);
+            EXPECT_STREQ(expected, data);
+        }
+
+        delete disk_manager;
+        remove("test.db");
+    }
+
+    TEST(BufferPoolManagerTest, StatsTest) {
+        page_id_t temp_page_id;
+        DiskManager *disk_manager = new DiskManager("test.db");
+        BufferPoolManager bpm(4, disk_manager);
+
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+        }
+        EXPECT_EQ(true, bpm.UnpinPage(0, true));
+        EXPECT_EQ(true, bpm.UnpinPage(1, true));
+        EXPECT_NE(nullptr, bpm.FetchPage(3));
+        EXPECT_NE(nullptr, bpm.FetchPage(3));
+        BufferPoolStats stats = bpm.GetStats();
+        EXPECT_EQ(2, stats.hits);
+        EXPECT_EQ(0, stats.misses);
+        EXPECT_EQ(4, stats.new_pages);
+        EXPECT_EQ(0, stats.evictions);
+        // pin counts 0, 0, 1 and 3
+        EXPECT_EQ(2, stats.pinned_frames[0]);
+        EXPECT_EQ(1, stats.pinned_frames[1]);
+        EXPECT_EQ(1, stats.pinned_frames[2]);
+        EXPECT_EQ(0, stats.pinned_frames[3]);
+
+        // both take a dirty victim
+        EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+        EXPECT_NE(nullptr, bpm.FetchPage(0));
+        EXPECT_EQ(false, bpm.DeletePage(0));
+        EXPECT_EQ(true, bpm.UnpinPage(0, false));
+        EXPECT_EQ(true, bpm.DeletePage(0));
+        stats = bpm.GetStats();
+        EXPECT_EQ(1, stats.misses);
+        EXPECT_EQ(5, stats.new_pages);
+        // the delete of the pinned page does not count
+        EXPECT_EQ(1, stats.delete_pages);
+        EXPECT_EQ(2, stats.evictions);
+        EXPECT_EQ(2, stats.write_backs);
+        EXPECT_EQ(2, stats.sync_writes);
+        EXPECT_EQ(1, stats.pinned_frames[0]);
+
+        delete disk_manager;
+        remove("test.db");
+    }
+
+    // a page that fails its checksum is not handed out, on a miss or read
+    // ahead, and its frame is not lost; a new page evicted before it was
+    // ever written reads as zeros
+    TEST(BufferPoolManagerTest, ReadFailureTest) {
+        page_id_t temp_page_id;
+        remove("test.db");
+        DiskManager *disk_manager = new DiskManager("test.db");
+        BufferPoolManager *bpm = new BufferPoolManager(16, disk_manager);
+        for (int i = 0; i < 8; ++i) {
+            Page *page = bpm->NewPage(temp_page_id);
+            ASSERT_NE(nullptr, page);
+            *reinterpret_cast<int *>(page->GetData()) = temp_page_id;
+            EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+        }
+        bpm->FlushAllPages();
+        delete bpm;
+        FILE *file = fopen("test.db", "r+b");
+        ASSERT_NE(nullptr, file);
+        fseek(file, 5 * PAGE_SIZE + 100, SEEK_SET);
+        fputc('x', file);
+        fclose(file);
+
+        bpm = new BufferPoolManager(16, disk_manager);
+        EXPECT_EQ(nullptr, bpm->FetchPage(5));
+        EXPECT_EQ(nullptr, bpm->FetchPage(5));
+        EXPECT_EQ(2, bpm->GetStats().read_failures);
+        EXPECT_EQ(16, bpm->GetStats().pinned_frames[0]);
+        bpm->Prefetch(0, 8);
+        for (int i = 0; i < 200 && bpm->GetStats().read_failures < 3; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        EXPECT_EQ(3, bpm->GetStats().read_failures);
+        EXPECT_EQ(nullptr, bpm->FetchPage(5));
+        for (page_id_t page_id = 0; page_id < 8; ++page_id) {
+            if (page_id == 5) {
+                continue;
+            }
+            Page *page = bpm->FetchPage(page_id);
+            ASSERT_NE(nullptr, page);
+            EXPECT_EQ(page_id, *reinterpret_cast<int *>(page->GetData()));
+            EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+        }
+        EXPECT_EQ(16, bpm->GetStats().pinned_frames[0]);
+
+        // requests that wait for a failing read all get nullptr
+        std::vector<std::thread> threads;
+        std::atomic<int> found(0);
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 100; ++i) {
+                    if (bpm->FetchPage(5) != nullptr) {
+                        found++;
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(0, found);
+        EXPECT_EQ(16, bpm->GetStats().pinned_frames[0]);
+
+        // every frame can still be used
+        for (int i = 0; i < 16; ++i) {
+            EXPECT_NE(nullptr, bpm->NewPage(temp_page_id));
+        }
+        for (int i = 0; i < 16; ++i) {
+            EXPECT_EQ(true, bpm->UnpinPage(8 + i, false));
+        }
+        // the first of them is evicted first
+        page_id_t new_page_id = 8;
+        for (page_id_t page_id = 0; page_id < 16; ++page_id) {
+            if (page_id == 5) {
+                continue;
+            }
+            ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+            EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+        }
+        Page *page = bpm->FetchPage(new_page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(0, *reinterpret_cast<int *>(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(new_page_id, false));
+
+        delete bpm;
+        delete disk_manager;
+        remove("test.db");
+        remove("test.log");
+    }
+
+    // FetchPage/UnpinPage on pages that are all resident, from 1 to 32
+    // threads; hits do not take the pool latch, so throughput should not drop
+    // as threads are added (with CLOCK not even the replacer locks on unpin)
+    TEST(BufferPoolManagerTest, HitThroughputBenchmark) {
+        const int resident_pages = 32;
+        const int total_fetches = 1 << 18;
+        const ReplacerType types[] = {ReplacerType::LRU, ReplacerType::CLOCK};
+        const char *names[] = {"LRU", "CLOCK"};
+        page_id_t temp_page_id;
+
+        for (int r = 0; r < 2; ++r) {
+            DiskManager *disk_manager = new DiskManager("test.db");
+            BufferPoolManager *bpm =
+                    new BufferPoolManager(64, disk_manager, nullptr, types[r]);
+            for (int i = 0; i < resident_pages; ++i) {
+                ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+                EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, false));
+            }
+
+            for (int num_threads = 1; num_threads <= 32; num_threads *= 2) {
+                BufferPoolStats before = bpm->GetStats();
+                std::vector<std::thread> threads;
+                auto start = std::chrono::steady_clock::now();
+                for (int t = 0; t < num_threads; ++t) {
+                    threads.emplace_back([&, t] {
+                        std::mt19937 rng(t);
+                        for (int i = 0; i < total_fetches / num_threads; ++i) {
+                            page_id_t page_id = rng() % resident_pages;
+                            EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+                            bpm->UnpinPage(page_id, false);
+                        }
+                    });
+                }
+                for (auto &thread : threads) {
+                    thread.join();
+                }
+                std::chrono::duration<double> elapsed =
+                        std::chrono::steady_clock::now() - start;
+                BufferPoolStats after = bpm->GetStats();
+                EXPECT_EQ(before.misses, after.misses);
+                EXPECT_EQ(total_fetches, after.hits - before.hits);
+                printf("%-6s %2d threads: %.2f M hits/s\n", names[r], num_threads,
+                       total_fetches / elapsed.count() / 1e6);
+            }
+            EXPECT_EQ(true, bpm->CheckAllUnpined());
+
+            delete bpm;
+            delete disk_manager;
+            remove("test.db");
+        }
+    }
+
+    // grow past a full pool, shrink with dirty and pinned pages, grow back;
+    // the pages keep their content throughout
+    TEST(BufferPoolManagerTest, ResizeTest) {
+        for (ReplacerType type : {ReplacerType::LRU, ReplacerType::CLOCK,
+                                  ReplacerType::LRU_K, ReplacerType::ARC}) {
+            DiskManager *disk_manager = new DiskManager("test.db");
+            BufferPoolManager *bpm = new BufferPoolManager(
+                    4, disk_manager, nullptr, type, 8);
+            EXPECT_EQ(4U, bpm->GetPoolSize());
+            EXPECT_EQ(8U, bpm->GetMaxPoolSize());
+
+            page_id_t page_id;
+            for (int i = 0; i < 4; ++i) {
+                Page *page = bpm->NewPage(page_id);
+                ASSERT_NE(nullptr, page);
+                snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+            }
+            EXPECT_EQ(nullptr, bpm->NewPage(page_id));
+            // no further than the maximum
+            EXPECT_EQ(8U, bpm->Resize(100));
+            for (int i = 4; i < 8; ++i) {
+                Page *page = bpm->NewPage(page_id);
+                ASSERT_NE(nullptr, page);
+                snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+            }
+            EXPECT_EQ(8U, bpm->GetStats().pinned_frames[1]);
+            for (page_id = 0; page_id < 8; ++page_id) {
+                EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+            }
+
+            // pages 0 and 1 stay pinned, the other six are written back
+            bpm->FetchPage(0);
+            bpm->FetchPage(1);
+            EXPECT_EQ(2U, bpm->Resize(1));
+            BufferPoolStats stats = bpm->GetStats();
+            EXPECT_EQ(2U, stats.pool_size);
+            EXPECT_EQ(0U, stats.pinned_frames[0]);
+            EXPECT_EQ(6U, stats.write_backs);
+            EXPECT_EQ(true, bpm->UnpinPage(0, false));
+            EXPECT_EQ(true, bpm->UnpinPage(1, false));
+            EXPECT_EQ(1U, bpm->Resize(1));
+
+            char expected[32];
+            for (page_id = 0; page_id < 8; ++page_id) {
+                Page *page = bpm->FetchPage(page_id);
+                ASSERT_NE(nullptr, page);
+                snprintf(expected, sizeof(expected), "page %d", page_id);
+                EXPECT_STREQ(expected, page->GetData());
+                EXPECT_EQ(nullptr, bpm->FetchPage((page_id + 1) % 8));
+                EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+            }
+
+            // once grown back, a second pass over the pages only hits
+            EXPECT_EQ(8U, bpm->Resize(8));
+            for (int pass = 0; pass < 2; ++pass) {
+                size_t hits = bpm->GetStats().hits;
+                for (page_id = 0; page_id < 8; ++page_id) {
+                    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+                    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+                }
+                if (pass == 1) {
+                    EXPECT_EQ(hits + 8, bpm->GetStats().hits);
+                }
+            }
+            EXPECT_EQ(true, bpm->CheckAllUnpined());
+
+            delete bpm;
+            delete disk_manager;
+            remove("test.db");
+        }
+    }
+
+    // readers and writers keep going while the pool is resized back and forth
+    TEST(BufferPoolManagerTest, ResizeConcurrentTest) {
+        const int num_pages = 64;
+        const int num_threads = 4;
+        DiskManager *disk_manager = new DiskManager("test.db");
+        BufferPoolManager *bpm = new BufferPoolManager(
+                16, disk_manager, nullptr, ReplacerType::CLOCK, 32);
+        page_id_t page_id;
+        for (int i = 0; i < num_pages; ++i) {
+            Page *page = bpm->NewPage(page_id);
+            ASSERT_NE(nullptr, page);
+            memcpy(page->GetData(), &page_id, sizeof(page_id));
+            EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+        }
+
+        std::atomic<bool> stop(false);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t] {
+                std::mt19937 rng(t);
+                while (!stop) {
+                    page_id_t id = rng() % num_pages;
+                    Page *page = bpm->FetchPage(id);
+                    ASSERT_NE(nullptr, page);
+                    page_id_t stored;
+                    page->RLatch();
+                    memcpy(&stored, page->GetData(), sizeof(stored));
+                    page->RUnlatch();
+                    EXPECT_EQ(id, stored);
+                    bool dirty = rng() % 2 == 0;
+                    if (dirty) {
+                        page->WLatch();
+                        memcpy(page->GetData(), &id, sizeof(id));
+                        page->WUnlatch();
+                    }
+                    EXPECT_EQ(true, bpm->UnpinPage(id, dirty));
+                }
+            });
+        }
+        for (int i = 0; i < 200; ++i) {
+            // at most num_threads frames are pinned at any time
+            EXPECT_EQ(i % 2 ? 32U : 8U, bpm->Resize(i % 2 ? 32 : 8));
+        }
+        stop = true;
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(true, bpm->CheckAllUnpined());
+
+        delete bpm;
+        delete disk_manager;
+        remove("test.db");
+    }
+
+    // every thread fetches, writes and unpins a page of its own; the pages sit
+    // in adjacent frames, so this is where per-frame metadata sharing cache
+    // lines would show up as throughput dropping when threads are added
+    TEST(BufferPoolManagerTest, PrivatePageHitBenchmark) {
+        const int max_threads = 16;
+        const int fetches_per_thread = 1 << 16;
+        page_id_t temp_page_id;
+        printf("page descriptor: %zu bytes, %zu aligned\n", sizeof(Page),
+               alignof(Page));
+
+        DiskManager *disk_manager = new DiskManager("test.db");
+        BufferPoolManager *bpm = new BufferPoolManager(
+                max_threads, disk_manager, nullptr, ReplacerType::CLOCK);
+        for (int i = 0; i < max_threads; ++i) {
+            Page *page = bpm->NewPage(temp_page_id);
+            ASSERT_NE(nullptr, page);
+            EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(page) % CACHE_LINE_SIZE);
+            EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(page->GetData()) %
+                         bpm->GetPageSize());
+            EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, false));
+        }
+
+        for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+            std::vector<std::thread> threads;
+            auto start = std::chrono::steady_clock::now();
+            for (int t = 0; t < num_threads; ++t) {
+                threads.emplace_back([&, t] {
+                    for (int i = 0; i < fetches_per_thread; ++i) {
+                        Page *page = bpm->FetchPage(t);
+                        EXPECT_NE(nullptr, page);
+                        page->GetData()[0]++;
+                        bpm->UnpinPage(t, true);
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            std::chrono::duration<double> elapsed =
+                    std::chrono::steady_clock::now() - start;
+            printf("%2d threads: %.2f M hits/s\n", num_threads,
+                   num_threads * fetches_per_thread / elapsed.count() / 1e6);
+        }
+        EXPECT_EQ(true, bpm->CheckAllUnpined());
+
+        delete bpm;
+        delete disk_manager;
+        remove("test.db");
+    }
 
 } // namespace cmudb
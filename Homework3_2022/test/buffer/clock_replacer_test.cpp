@@ -0,0 +1,89 @@
+/**
+ * clock_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "buffer/clock_replacer.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+    TEST(ClockReplacerTest, SampleTest) {
+        ClockReplacer<int> clock_replacer(0, 7);
+
+        // push element into replacer
+        clock_replacer.Insert(1);
+        clock_replacer.Insert(2);
+        clock_replacer.Insert(3);
+        clock_replacer.Insert(4);
+        clock_replacer.Insert(5);
+        clock_replacer.Insert(6);
+        clock_replacer.Insert(1);
+        EXPECT_EQ(6, clock_replacer.Size());
+
+        // first sweep clears every reference bit, then frames go in hand order
+        int value;
+        EXPECT_EQ(true, clock_replacer.Victim(value));
+        EXPECT_EQ(1, value);
+        EXPECT_EQ(true, clock_replacer.Victim(value));
+        EXPECT_EQ(2, value);
+
+        // a referenced frame gets a second chance
+        clock_replacer.Insert(4);
+        EXPECT_EQ(true, clock_replacer.Victim(value));
+        EXPECT_EQ(3, value);
+        EXPECT_EQ(true, clock_replacer.Victim(value));
+        EXPECT_EQ(5, value);
+
+        // remove element from replacer
+        EXPECT_EQ(false, clock_replacer.Erase(5));
+        EXPECT_EQ(true, clock_replacer.Erase(6));
+        EXPECT_EQ(1, clock_replacer.Size());
+
+        EXPECT_EQ(true, clock_replacer.Victim(value));
+        EXPECT_EQ(4, value);
+        EXPECT_EQ(false, clock_replacer.Victim(value));
+        EXPECT_EQ(0, clock_replacer.Size());
+    }
+
+    TEST(ClockReplacerTest, ConcurrentPinUnpinTest) {
+        const int num_frames = 64;
+        const int num_threads = 4;
+        ClockReplacer<int> clock_replacer(0, num_frames);
+
+        // each thread owns a disjoint set of frames and pins/unpins them
+        std::vector<std::thread> threads;
+        for (int tid = 0; tid < num_threads; ++tid) {
+            threads.push_back(std::thread([tid, &clock_replacer]() {
+                for (int round = 0; round < 1000; ++round) {
+                    for (int i = tid; i < num_frames; i += num_threads) {
+                        clock_replacer.Insert(i);
+                    }
+                    for (int i = tid; i < num_frames; i += num_threads) {
+                        EXPECT_EQ(true, clock_replacer.Erase(i));
+                    }
+                }
+                for (int i = tid; i < num_frames; i += num_threads) {
+                    clock_replacer.Insert(i);
+                }
+            }));
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(num_frames, clock_replacer.Size());
+
+        std::vector<bool> seen(num_frames, false);
+        int value;
+        for (int i = 0; i < num_frames; ++i) {
+            EXPECT_EQ(true, clock_replacer.Victim(value));
+            EXPECT_EQ(false, seen[value]);
+            seen[value] = true;
+        }
+        EXPECT_EQ(false, clock_replacer.Victim(value));
+    }
+
+} // namespace scudb
@@ -0,0 +1,235 @@
+/**
+ * lru_k_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "index/b_plus_tree.h"
+#include "logging/common.h"
+#include "table/table_heap.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+    TEST(LRUKReplacerTest, SampleTest) {
+        LRUKReplacer<int> lru_k_replacer(2, 0);
+        int value;
+
+        EXPECT_EQ(false, lru_k_replacer.Victim(value));
+
+        // 1 and 2 are referenced twice, 3 and 4 only once
+        lru_k_replacer.Insert(1);
+        lru_k_replacer.Insert(2);
+        lru_k_replacer.Insert(3);
+        lru_k_replacer.Insert(1);
+        lru_k_replacer.Insert(4);
+        lru_k_replacer.Insert(2);
+        EXPECT_EQ(4, lru_k_replacer.Size());
+
+        // infinite K-distance first, in LRU order
+        EXPECT_EQ(true, lru_k_replacer.Victim(value));
+        EXPECT_EQ(3, value);
+        EXPECT_EQ(true, lru_k_replacer.Victim(value));
+        EXPECT_EQ(4, value);
+        // then the oldest second-to-last reference
+        EXPECT_EQ(true, lru_k_replacer.Victim(value));
+        EXPECT_EQ(1, value);
+
+        // pinning keeps the history
+        EXPECT_EQ(true, lru_k_replacer.Erase(2));
+        EXPECT_EQ(false, lru_k_replacer.Erase(2));
+        EXPECT_EQ(false, lru_k_replacer.Victim(value));
+        lru_k_replacer.Insert(5);
+        lru_k_replacer.Insert(2);
+        EXPECT_EQ(true, lru_k_replacer.Victim(value));
+        EXPECT_EQ(5, value);
+        EXPECT_EQ(true, lru_k_replacer.Victim(value));
+        EXPECT_EQ(2, value);
+        EXPECT_EQ(0, lru_k_replacer.Size());
+    }
+
+    TEST(LRUKReplacerTest, PrefetchedTest) {
+        LRUKReplacer<int> lru_k_replacer(2, 1);
+        int value;
+
+        // 1 is referenced twice. 2 is read ahead, then used once; the
+        // read-ahead does not split the back-to-back references to 3 either
+        lru_k_replacer.Insert(1);
+        lru_k_replacer.Insert(4);
+        lru_k_replacer.Insert(1);
+        lru_k_replacer.Insert(3);
+        lru_k_replacer.InsertPrefetched(2);
+        lru_k_replacer.Insert(3);
+        lru_k_replacer.Insert(2);
+        EXPECT_EQ(4, lru_k_replacer.Size());
+
+        // 4, 3 and 2 have one reference each
+        for (int expected : {4, 3, 2, 1}) {
+            EXPECT_EQ(true, lru_k_replacer.Victim(value));
+            EXPECT_EQ(expected, value);
+        }
+    }
+
+    TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+        LRUKReplacer<int> lru_k_replacer(2, 1);
+        int value;
+
+        // back-to-back references to 1 count once, 2 is referenced twice
+        lru_k_replacer.Insert(2);
+        lru_k_replacer.Insert(1);
+        lru_k_replacer.Insert(1);
+        lru_k_replacer.Insert(1);
+        lru_k_replacer.Insert(2);
+        EXPECT_EQ(true, lru_k_replacer.Victim(value));
+        EXPECT_EQ(1, value);
+        EXPECT_EQ(true, lru_k_replacer.Victim(value));
+        EXPECT_EQ(2, value);
+    }
+
+    TEST(LRUKReplacerTest, CandidatesTest) {
+        LRUKReplacer<int> lru_k_replacer(2, 0);
+        int value;
+
+        lru_k_replacer.Insert(1);
+        lru_k_replacer.Insert(2);
+        lru_k_replacer.Insert(1);
+        lru_k_replacer.Insert(3);
+        lru_k_replacer.Erase(3);
+
+        // peeking follows the victim order and removes nothing
+        std::vector<int> candidates;
+        lru_k_replacer.Candidates(candidates, 5);
+        EXPECT_EQ(std::vector<int>({2, 1}), candidates);
+        EXPECT_EQ(2, lru_k_replacer.Size());
+
+        // evicting out of order drops the history too
+        EXPECT_EQ(true, lru_k_replacer.Evict(1));
+        EXPECT_EQ(false, lru_k_replacer.Evict(3));
+        lru_k_replacer.Insert(1);
+        EXPECT_EQ(true, lru_k_replacer.Victim(value));
+        EXPECT_EQ(2, value);
+        EXPECT_EQ(true, lru_k_replacer.Victim(value));
+        EXPECT_EQ(1, value);
+    }
+
+    TEST(LRUKReplacerTest, ForgetTest) {
+        LRUKReplacer<int> lru_k_replacer(2, 0);
+        int value;
+
+        // 1 is referenced twice, pinned, and then its frame is freed
+        lru_k_replacer.Insert(1);
+        lru_k_replacer.Insert(1);
+        lru_k_replacer.Erase(1);
+        lru_k_replacer.Forget(1);
+        lru_k_replacer.Forget(3);
+        EXPECT_EQ(0, lru_k_replacer.Size());
+
+        // the frame's next page starts with one reference, like 2
+        lru_k_replacer.Insert(1);
+        lru_k_replacer.Insert(2);
+        lru_k_replacer.Insert(2);
+        EXPECT_EQ(true, lru_k_replacer.Victim(value));
+        EXPECT_EQ(1, value);
+
+        // an evictable frame can be forgotten too
+        lru_k_replacer.Forget(2);
+        EXPECT_EQ(0, lru_k_replacer.Size());
+        EXPECT_EQ(false, lru_k_replacer.Victim(value));
+    }
+
+    // a pool that ignores read-ahead: the background reads would race with
+    // the lookups whose reads are counted
+    class NoPrefetchBufferPoolManager : public BufferPoolManager {
+    public:
+        using BufferPoolManager::BufferPoolManager;
+        void Prefetch(page_id_t, size_t) override {}
+    };
+
+    // point lookups on a B+ tree, then a full table scan through a small pool;
+    // count the page reads that repeating the lookups costs afterwards
+    static int LookupMissesAfterScan(ReplacerType replacer_type) {
+        Schema *schema = ParseCreateStatement("a varchar, b smallint, c bigint");
+        Schema *key_schema = ParseCreateStatement("a bigint");
+        GenericComparator<8> comparator(key_schema);
+        Transaction *transaction = new Transaction(0);
+        DiskManager *disk_manager = new DiskManager("test.db");
+        BufferPoolManager *bpm =
+                new NoPrefetchBufferPoolManager(16, disk_manager, nullptr,
+                                                replacer_type);
+        LockManager *lock_manager = new LockManager(true);
+        LogManager *log_manager = new LogManager(disk_manager);
+
+        page_id_t header_page_id;
+        bpm->NewPage(header_page_id);
+        bpm->UnpinPage(header_page_id, true);
+
+        RID rid;
+        BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                                 comparator);
+        tree.openCheck = false;
+        GenericKey<8> index_key;
+        for (int64_t key = 1; key <= 200; ++key) {
+            rid.Set(0, key);
+            index_key.SetFromInteger(key);
+            tree.Insert(index_key, rid, transaction);
+        }
+
+        TableHeap *table = new TableHeap(bpm, lock_manager, log_manager, transaction);
+        Tuple tuple = ConstructTuple(schema);
+        for (int i = 0; i < 1000; ++i) {
+            table->InsertTuple(tuple, rid, transaction);
+        }
+
+        // the hot set: a handful of keys, looked up again and again
+        std::vector<RID> rids;
+        for (int round = 0; round < 5; ++round) {
+            for (int64_t key = 1; key <= 40; key += 4) {
+                rids.clear();
+                index_key.SetFromInteger(key);
+                tree.GetValue(index_key, rids);
+                EXPECT_EQ(1, rids.size());
+            }
+        }
+
+        int scanned = 0;
+        for (auto itr = table->begin(transaction); itr != table->end(); ++itr) {
+            scanned++;
+        }
+        EXPECT_EQ(1000, scanned);
+
+        int reads_before = disk_manager->GetNumReads();
+        for (int64_t key = 1; key <= 40; key += 4) {
+            rids.clear();
+            index_key.SetFromInteger(key);
+            tree.GetValue(index_key, rids);
+            EXPECT_EQ(1, rids.size());
+        }
+        int misses = disk_manager->GetNumReads() - reads_before;
+
+        delete table;
+        delete bpm;
+        delete log_manager;
+        delete lock_manager;
+        delete disk_manager;
+        delete transaction;
+        delete key_schema;
+        delete schema;
+        remove("test.db");
+        remove("test.log");
+        return misses;
+    }
+
+    TEST(LRUKReplacerTest, ScanResistanceTest) {
+        int lru_misses = LookupMissesAfterScan(ReplacerType::LRU);
+        int lru_k_misses = LookupMissesAfterScan(ReplacerType::LRU_K);
+        printf("index page misses after scan: LRU %d, LRU-K %d\n", lru_misses,
+               lru_k_misses);
+        // the scan pushes the index out of an LRU pool but not out of LRU-K
+        EXPECT_LT(0, lru_misses);
+        EXPECT_EQ(0, lru_k_misses);
+    }
+
+} // namespace scudb
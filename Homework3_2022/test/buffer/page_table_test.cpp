@@ -0,0 +1,119 @@
+/**
+ * page_table_test.cpp
+ */
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/page_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+    TEST(PageTableTest, SampleTest) {
+        PageTable page_table(4);
+        frame_id_t frame_id;
+
+        EXPECT_EQ(false, page_table.Find(1, frame_id));
+        page_table.Insert(1, 0);
+        page_table.Insert(9, 1);
+        page_table.Insert(17, 2);
+        page_table.Insert(2, 3);
+        EXPECT_EQ(true, page_table.Find(9, frame_id));
+        EXPECT_EQ(1, frame_id);
+
+        // removing an entry moves the ones probed after it, they stay findable
+        EXPECT_EQ(true, page_table.Remove(1));
+        EXPECT_EQ(false, page_table.Remove(1));
+        EXPECT_EQ(false, page_table.Find(1, frame_id));
+        frame_id_t expected = 1;
+        for (page_id_t page_id : {9, 17, 2}) {
+            EXPECT_EQ(true, page_table.Find(page_id, frame_id));
+            EXPECT_EQ(expected++, frame_id);
+        }
+        page_table.Insert(1, 0);
+        EXPECT_EQ(true, page_table.Find(1, frame_id));
+        EXPECT_EQ(0, frame_id);
+    }
+
+    // random inserts and removes, checked against std::unordered_map
+    TEST(PageTableTest, RandomTest) {
+        const int num_frames = 64;
+        PageTable page_table(num_frames);
+        std::unordered_map<page_id_t, frame_id_t> expected;
+        std::vector<frame_id_t> free_frames;
+        for (frame_id_t i = 0; i < num_frames; ++i) {
+            free_frames.push_back(i);
+        }
+
+        std::mt19937 rng(0);
+        frame_id_t frame_id;
+        for (int i = 0; i < 100000; ++i) {
+            page_id_t page_id = rng() % 1000;
+            auto it = expected.find(page_id);
+            if (it != expected.end()) {
+                EXPECT_EQ(true, page_table.Find(page_id, frame_id));
+                EXPECT_EQ(it->second, frame_id);
+                EXPECT_EQ(true, page_table.Remove(page_id));
+                free_frames.push_back(it->second);
+                expected.erase(it);
+            } else if (!free_frames.empty()) {
+                EXPECT_EQ(false, page_table.Find(page_id, frame_id));
+                page_table.Insert(page_id, free_frames.back());
+                expected[page_id] = free_frames.back();
+                free_frames.pop_back();
+            }
+        }
+        for (auto &entry : expected) {
+            EXPECT_EQ(true, page_table.Find(entry.first, frame_id));
+            EXPECT_EQ(entry.second, frame_id);
+        }
+    }
+
+    // lock-free lookups while one writer churns: a lookup may miss, but
+    // whatever it finds is the frame the page was given
+    TEST(PageTableTest, ConcurrentFindTest) {
+        const int num_frames = 32;
+        PageTable page_table(num_frames);
+        // page i always gets frame i % num_frames
+        for (page_id_t page_id = 0; page_id < num_frames / 2; ++page_id) {
+            page_table.Insert(page_id, page_id);
+        }
+
+        std::atomic<bool> stop(false);
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back([&, t] {
+                std::mt19937 rng(t);
+                frame_id_t frame_id;
+                while (!stop) {
+                    page_id_t page_id = rng() % 1024;
+                    if (page_table.Find(page_id, frame_id)) {
+                        EXPECT_EQ(page_id % num_frames, frame_id);
+                    }
+                }
+            });
+        }
+
+        // the writer moves pages in and out of frames num_frames / 2 and up
+        std::mt19937 rng(42);
+        std::vector<page_id_t> churn(num_frames / 2, INVALID_PAGE_ID);
+        for (int i = 0; i < 20000; ++i) {
+            frame_id_t frame_id = num_frames / 2 + rng() % (num_frames / 2);
+            page_id_t &page_id = churn[frame_id - num_frames / 2];
+            if (page_id != INVALID_PAGE_ID) {
+                EXPECT_EQ(true, page_table.Remove(page_id));
+            }
+            page_id = frame_id + num_frames * (1 + rng() % 31);
+            page_table.Insert(page_id, frame_id);
+        }
+        stop = true;
+        for (auto &reader : readers) {
+            reader.join();
+        }
+    }
+
+} // namespace scudb
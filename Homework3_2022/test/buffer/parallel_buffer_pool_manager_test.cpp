@@ -0,0 +1,215 @@
+/**
+ * parallel_buffer_pool_manager_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+    TEST(ParallelBufferPoolManagerTest, SampleTest) {
+        page_id_t temp_page_id;
+
+        DiskManager *disk_manager = new DiskManager("test.db");
+        ParallelBufferPoolManager *bpm = new ParallelBufferPoolManager(4, 12, disk_manager);
+
+        auto page_zero = bpm->NewPage(temp_page_id);
+        ASSERT_NE(nullptr, page_zero);
+        EXPECT_EQ(0, temp_page_id);
+        strcpy(page_zero->GetData(), "Hello");
+
+        for (int i = 1; i < 12; ++i) {
+            EXPECT_NE(nullptr, bpm->NewPage(temp_page_id));
+            EXPECT_EQ(i, temp_page_id);
+        }
+        // every frame of every instance is pinned
+        EXPECT_EQ(nullptr, bpm->NewPage(temp_page_id));
+
+        // unpin the first four pages, one per instance
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_EQ(true, bpm->UnpinPage(i, true));
+        }
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_NE(nullptr, bpm->NewPage(temp_page_id));
+            EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, false));
+        }
+
+        // page zero was evicted and must come back from disk
+        page_zero = bpm->FetchPage(0);
+        ASSERT_NE(nullptr, page_zero);
+        EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
+        EXPECT_EQ(true, bpm->UnpinPage(0, false));
+        EXPECT_EQ(true, bpm->DeletePage(0));
+
+        delete bpm;
+        delete disk_manager;
+        remove("test.db");
+        remove("test.log");
+    }
+
+    TEST(ParallelBufferPoolManagerTest, NewPageOnOtherInstance) {
+        page_id_t temp_page_id;
+
+        DiskManager *disk_manager = new DiskManager("test.db");
+        ParallelBufferPoolManager *bpm = new ParallelBufferPoolManager(2, 4, disk_manager);
+
+        // pages 0..3 fill both instances, free the ones on instance 1
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+        }
+        EXPECT_EQ(true, bpm->UnpinPage(1, false));
+        EXPECT_EQ(true, bpm->UnpinPage(3, false));
+
+        // page 4 belongs to the full instance 0 and goes to instance 1, no
+        // id is skipped
+        Page *page = bpm->NewPage(temp_page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(4, temp_page_id);
+        strcpy(page->GetData(), "Hello");
+        ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+        EXPECT_EQ(5, temp_page_id);
+        EXPECT_EQ(nullptr, bpm->NewPage(temp_page_id));
+        EXPECT_EQ(1, disk_manager->GetNumFreePages(0));
+
+        // page 4 is evicted from instance 1 and read back into it
+        EXPECT_EQ(true, bpm->UnpinPage(4, true));
+        EXPECT_EQ(true, bpm->UnpinPage(5, false));
+        for (int i = 0; i < 2; ++i) {
+            ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+            EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, false));
+        }
+        page = bpm->FetchPage(4);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(0, strcmp(page->GetData(), "Hello"));
+        EXPECT_EQ(true, bpm->UnpinPage(4, false));
+        EXPECT_EQ(true, bpm->DeletePage(4));
+
+        delete bpm;
+        delete disk_manager;
+        remove("test.db");
+        remove("test.log");
+    }
+
+    TEST(ParallelBufferPoolManagerTest, ConcurrentFetchOfPlacedPage) {
+        page_id_t temp_page_id;
+
+        DiskManager *disk_manager = new DiskManager("test.db");
+        ParallelBufferPoolManager *bpm = new ParallelBufferPoolManager(2, 8, disk_manager);
+
+        // pages 0..7 fill both instances, free the ones on instance 1 so that
+        // page 8 goes there
+        for (int i = 0; i < 8; ++i) {
+            Page *page = bpm->NewPage(temp_page_id);
+            ASSERT_NE(nullptr, page);
+            memcpy(page->GetData(), &temp_page_id, sizeof(temp_page_id));
+        }
+        for (int i = 1; i < 8; i += 2) {
+            EXPECT_EQ(true, bpm->UnpinPage(i, true));
+        }
+        Page *page = bpm->NewPage(temp_page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(8, temp_page_id);
+        memcpy(page->GetData(), &temp_page_id, sizeof(temp_page_id));
+        EXPECT_EQ(true, bpm->UnpinPage(8, true));
+        for (int i = 0; i < 8; i += 2) {
+            EXPECT_EQ(true, bpm->UnpinPage(i, true));
+        }
+
+        // each thread pins one page at a time, every instance has room for
+        // all of them; a page loaded into two instances would lose writes
+        std::vector<std::thread> threads;
+        for (int tid = 0; tid < 4; ++tid) {
+            threads.push_back(std::thread([=]() {
+                std::mt19937 gen(tid);
+                std::uniform_int_distribution<int> dist(0, 8);
+                for (int i = 0; i < 20000; ++i) {
+                    page_id_t page_id = dist(gen);
+                    Page *page = bpm->FetchPage(page_id);
+                    EXPECT_NE(nullptr, page);
+                    if (page == nullptr) {
+                        return;
+                    }
+                    EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+                    bpm->UnpinPage(page_id, false);
+                }
+            }));
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(true, bpm->CheckAllUnpined());
+        EXPECT_EQ(true, bpm->DeletePage(8));
+
+        delete bpm;
+        delete disk_manager;
+        remove("test.db");
+        remove("test.log");
+    }
+
+    // fetch/unpin throughput of a single latch versus a sharded pool
+    static double HitThroughput(BufferPoolManager *bpm, int num_pages,
+                                int num_threads, int ops_per_thread) {
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (int tid = 0; tid < num_threads; ++tid) {
+            threads.push_back(std::thread([=]() {
+                std::mt19937 gen(tid);
+                std::uniform_int_distribution<int> dist(0, num_pages - 1);
+                for (int i = 0; i < ops_per_thread; ++i) {
+                    page_id_t page_id = dist(gen);
+                    Page *page = bpm->FetchPage(page_id);
+                    EXPECT_NE(nullptr, page);
+                    if (page == nullptr) {
+                        return;
+                    }
+                    EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+                    bpm->UnpinPage(page_id, false);
+                }
+            }));
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return num_threads * ops_per_thread / elapsed.count();
+    }
+
+    TEST(ParallelBufferPoolManagerTest, ScalingTest) {
+        const int num_pages = 256;
+        const int ops_per_thread = 50000;
+
+        for (int num_instances : {1, 8}) {
+            DiskManager *disk_manager = new DiskManager("test.db");
+            BufferPoolManager *bpm =
+                    num_instances == 1
+                    ? new BufferPoolManager(num_pages, disk_manager)
+                    : new ParallelBufferPoolManager(num_instances, num_pages, disk_manager);
+            page_id_t page_id;
+            for (int i = 0; i < num_pages; ++i) {
+                Page *page = bpm->NewPage(page_id);
+                ASSERT_NE(nullptr, page);
+                memcpy(page->GetData(), &page_id, sizeof(page_id));
+                bpm->UnpinPage(page_id, true);
+            }
+
+            for (int num_threads : {1, 2, 4, 8}) {
+                double ops = HitThroughput(bpm, num_pages, num_threads, ops_per_thread);
+                printf("instances %d threads %d: %.0f fetches/s\n", num_instances,
+                       num_threads, ops);
+            }
+            EXPECT_EQ(true, bpm->CheckAllUnpined());
+
+            delete bpm;
+            delete disk_manager;
+            remove("test.db");
+            remove("test.log");
+        }
+    }
+
+} // namespace scudb
@@ -0,0 +1,112 @@
+/**
+ * async_io_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+#include "disk/async_io.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+static IOCompletion SubmitIO(AsyncIO *async_io, bool is_write, int fd,
+                             char *data, size_t size, off_t offset) {
+  std::unique_ptr<IORequest> request(new IORequest());
+  request->is_write = is_write;
+  request->fd = fd;
+  request->data = data;
+  request->size = size;
+  request->offset = offset;
+  return async_io->Submit(std::move(request));
+}
+
+// many requests in flight at once, more than an io_uring has entries
+TEST(AsyncIOTest, ReadWriteTest) {
+  const int num_blocks = 200;
+  const size_t block_size = 4096;
+  for (AsyncIOType type : {AsyncIOType::IO_URING, AsyncIOType::THREAD_POOL}) {
+    std::unique_ptr<AsyncIO> async_io = AsyncIO::Create(type);
+    if (async_io == nullptr) {
+      printf("io_uring not available, skipped\n");
+      continue;
+    }
+    EXPECT_EQ(type, async_io->GetType());
+    int fd = open("test.db", O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_LE(0, fd);
+
+    std::vector<char> data(num_blocks * block_size);
+    std::vector<IOCompletion> completions;
+    for (int i = 0; i < num_blocks; i++) {
+      memset(&data[i * block_size], i, block_size);
+      completions.push_back(SubmitIO(async_io.get(), true, fd,
+                                     &data[i * block_size], block_size,
+                                     i * block_size));
+    }
+    for (auto &completion : completions) {
+      EXPECT_EQ(true, completion.get());
+    }
+
+    std::vector<char> buf(num_blocks * block_size);
+    completions.clear();
+    for (int i = num_blocks - 1; i >= 0; i--) {
+      completions.push_back(SubmitIO(async_io.get(), false, fd,
+                                     &buf[i * block_size], block_size,
+                                     i * block_size));
+    }
+    for (auto &completion : completions) {
+      EXPECT_EQ(true, completion.get());
+    }
+    EXPECT_EQ(0, memcmp(data.data(), buf.data(), data.size()));
+
+    // reading past the end of the file is short, the request fails
+    EXPECT_EQ(false, SubmitIO(async_io.get(), false, fd, buf.data(),
+                              block_size, (num_blocks + 1) * block_size)
+                         .get());
+    close(fd);
+    remove("test.db");
+  }
+}
+
+// a write gathering several buffers lands at consecutive offsets
+TEST(AsyncIOTest, VectoredWriteTest) {
+  const int num_blocks = 8;
+  const size_t block_size = 4096;
+  for (AsyncIOType type : {AsyncIOType::IO_URING, AsyncIOType::THREAD_POOL}) {
+    std::unique_ptr<AsyncIO> async_io = AsyncIO::Create(type);
+    if (async_io == nullptr) {
+      printf("io_uring not available, skipped\n");
+      continue;
+    }
+    int fd = open("test.db", O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_LE(0, fd);
+    std::vector<std::vector<char>> blocks;
+    std::unique_ptr<IORequest> request(new IORequest());
+    request->is_write = true;
+    request->fd = fd;
+    request->data = nullptr;
+    request->size = num_blocks * block_size;
+    request->offset = block_size;
+    for (int i = 0; i < num_blocks; i++) {
+      blocks.emplace_back(block_size, static_cast<char>(i + 1));
+      request->iov.push_back({blocks.back().data(), block_size});
+    }
+    uint64_t syscalls = async_io->GetNumSyscalls();
+    EXPECT_EQ(true, async_io->Submit(std::move(request)).get());
+    EXPECT_LT(syscalls, async_io->GetNumSyscalls());
+
+    std::vector<char> buf(block_size);
+    for (int i = 0; i < num_blocks; i++) {
+      EXPECT_EQ(block_size, (size_t)pread(fd, buf.data(), block_size,
+                                          (i + 1) * block_size));
+      EXPECT_EQ(0, memcmp(blocks[i].data(), buf.data(), block_size));
+    }
+    close(fd);
+    remove("test.db");
+  }
+}
+
+} // namespace scudb
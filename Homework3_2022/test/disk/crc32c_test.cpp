@@ -0,0 +1,46 @@
+/**
+ * crc32c_test.cpp
+ */
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "disk/crc32c.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+// known values, and the hardware path agrees with the tables at every
+// length and alignment, also when continued from an earlier CRC
+TEST(Crc32cTest, ValueTest) {
+  printf("crc32 instruction: %s\n", Crc32cHasHardware() ? "yes" : "no");
+  EXPECT_EQ(0U, Crc32c("", 0));
+  EXPECT_EQ(0xe3069283U, Crc32c("123456789", 9));
+  EXPECT_EQ(0xe3069283U, Crc32cSoftware("123456789", 9));
+  std::vector<char> bytes(32, 0);
+  EXPECT_EQ(0x8a9136aaU, Crc32c(bytes.data(), bytes.size()));
+  memset(bytes.data(), 0xff, bytes.size());
+  EXPECT_EQ(0x62a8ab43U, Crc32c(bytes.data(), bytes.size()));
+
+  std::mt19937 rng(5);
+  std::vector<char> data(3 * 4096 + 8);
+  for (auto &c : data) {
+    c = static_cast<char>(rng());
+  }
+  for (size_t size = 0; size <= 4200; size += 1 + size / 16) {
+    for (size_t offset = 0; offset < 8; ++offset) {
+      const char *p = data.data() + offset;
+      uint32_t crc = Crc32cSoftware(p, size);
+      EXPECT_EQ(crc, Crc32c(p, size));
+      size_t half = size / 3;
+      EXPECT_EQ(crc, Crc32c(p + half, size - half, Crc32c(p, half)));
+    }
+  }
+  uint32_t crc = Crc32c(data.data(), data.size());
+  EXPECT_EQ(crc, Crc32cSoftware(data.data(), data.size()));
+  data[4096] ^= 1;
+  EXPECT_NE(crc, Crc32c(data.data(), data.size()));
+}
+
+} // namespace scudb
@@ -0,0 +1,852 @@
+/**
+ * disk_manager_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <random>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/aligned_buffer.h"
+#include "common/exception.h"
+#include "disk/crc32c.h"
+#include "disk/disk_manager.h"
+#include "page/header_page.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+// bytes of a page before its checksum, what a write stores as given
+static const size_t DATA_SIZE = PAGE_SIZE - PAGE_CHECKSUM_SIZE;
+
+// pages of the file grow with the writes and survive a reopen
+TEST(DiskManagerTest, ReadWriteTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<char> data(PAGE_SIZE), buf(PAGE_SIZE);
+  EXPECT_EQ(0, disk_manager->GetNumPages());
+
+  // a page past the end reads as zeros
+  buf[0] = 1;
+  disk_manager->ReadPage(0, buf.data());
+  EXPECT_EQ(0, buf[0]);
+
+  strcpy(data.data(), "A test string.");
+  disk_manager->WritePage(3, data.data());
+  EXPECT_EQ(4, disk_manager->GetNumPages());
+  disk_manager->ReadPage(3, buf.data());
+  EXPECT_EQ(0, memcmp(data.data(), buf.data(), DATA_SIZE));
+
+  const char *pages[] = {data.data(), data.data()};
+  disk_manager->WritePages(4, pages, 2);
+  EXPECT_EQ(6, disk_manager->GetNumPages());
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(6, disk_manager->GetNumPages());
+  disk_manager->ReadPage(5, buf.data());
+  EXPECT_EQ(0, memcmp(data.data(), buf.data(), DATA_SIZE));
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// threads write and read back pages of their own at the same time, with no
+// lock around the disk manager
+TEST(DiskManagerTest, ConcurrentTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 64;
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      std::vector<char> data(PAGE_SIZE), buf(PAGE_SIZE);
+      for (int round = 0; round < 4; ++round) {
+        for (int i = 0; i < pages_per_thread; ++i) {
+          page_id_t page_id = i * num_threads + t;
+          memset(data.data(), page_id + round, PAGE_SIZE);
+          disk_manager->WritePage(page_id, data.data());
+          disk_manager->ReadPage(page_id, buf.data());
+          EXPECT_EQ(0, memcmp(data.data(), buf.data(), DATA_SIZE));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * pages_per_thread, disk_manager->GetNumPages());
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// asynchronous writes and reads go through the same file as the others
+TEST(DiskManagerTest, AsyncTest) {
+  const int num_pages = 100;
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+
+  std::vector<char> data(num_pages * PAGE_SIZE), buf(num_pages * PAGE_SIZE);
+  std::vector<IOCompletion> completions;
+  for (int i = 0; i < num_pages; ++i) {
+    memset(&data[i * PAGE_SIZE], i + 1, PAGE_SIZE);
+    completions.push_back(
+        disk_manager->WritePageAsync(i, &data[i * PAGE_SIZE]));
+  }
+  for (auto &completion : completions) {
+    EXPECT_EQ(true, completion.get());
+  }
+  EXPECT_EQ(num_pages, disk_manager->GetNumPages());
+
+  completions.clear();
+  for (int i = 0; i < num_pages; ++i) {
+    completions.push_back(disk_manager->ReadPageAsync(i, &buf[i * PAGE_SIZE]));
+  }
+  for (auto &completion : completions) {
+    EXPECT_EQ(true, completion.get());
+  }
+  for (int i = 0; i < num_pages; ++i) {
+    EXPECT_EQ(0, memcmp(&data[i * PAGE_SIZE], &buf[i * PAGE_SIZE], DATA_SIZE));
+  }
+  disk_manager->ReadPage(num_pages - 1, buf.data());
+  EXPECT_EQ(num_pages, buf[0]);
+
+  // past the end of the file: zeros, and the read fails
+  buf[0] = 1;
+  EXPECT_EQ(false, disk_manager->ReadPageAsync(num_pages + 1, buf.data()).get());
+  EXPECT_EQ(0, buf[0]);
+  printf("asynchronous I/O backend: %s\n",
+         disk_manager->GetAsyncIO()->GetType() == AsyncIOType::IO_URING
+             ? "io_uring"
+             : "thread pool");
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// deleted pages are reused before the file grows, and with a header page
+// the free list and the next new page id survive a reopen
+TEST(DiskManagerTest, FreePageTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  page_id_t page_id;
+  HeaderPage *header_page =
+      static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  ASSERT_EQ(HEADER_PAGE_ID, page_id);
+  header_page->Init();
+  EXPECT_EQ(true, header_page->InsertRecord("table", 1));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  for (int i = 1; i <= 8; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    EXPECT_EQ(i, page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  EXPECT_EQ(9, disk_manager->GetNumPages());
+
+  // the header page is never freed
+  EXPECT_EQ(true, bpm->DeletePage(HEADER_PAGE_ID));
+  for (page_id_t deleted : {3, 5, 7}) {
+    EXPECT_EQ(true, bpm->DeletePage(deleted));
+  }
+  EXPECT_EQ(3, disk_manager->GetNumFreePages());
+  // a page deleted twice is on the list once, it does not become a cycle
+  EXPECT_EQ(true, bpm->DeletePage(5));
+  EXPECT_EQ(3, disk_manager->GetNumFreePages());
+  // last freed, first reused
+  Page *page = bpm->NewPage(page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(7, page_id);
+  EXPECT_EQ(0, page->GetData()[0]);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  EXPECT_EQ(2, disk_manager->GetNumFreePages());
+
+  // the header page is written with the free space of the disk manager,
+  // whatever the frame has
+  page = bpm->FetchPage(HEADER_PAGE_ID);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(true, bpm->UnpinPage(HEADER_PAGE_ID, true));
+  bpm->FlushAllPages();
+  delete bpm;
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(2, disk_manager->GetNumFreePages());
+  EXPECT_EQ(5, disk_manager->AllocatePage());
+  EXPECT_EQ(3, disk_manager->AllocatePage());
+  EXPECT_EQ(9, disk_manager->AllocatePage());
+  EXPECT_EQ(0, disk_manager->GetNumFreePages());
+  // a page handed out and freed again before any header write
+  disk_manager->DeallocatePage(9);
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(1, disk_manager->GetNumFreePages());
+  EXPECT_EQ(9, disk_manager->AllocatePage());
+  EXPECT_EQ(10, disk_manager->AllocatePage());
+  bpm = new BufferPoolManager(10, disk_manager);
+  header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  ASSERT_NE(nullptr, header_page);
+  EXPECT_EQ(true, header_page->GetRootId("table", page_id));
+  EXPECT_EQ(1, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(HEADER_PAGE_ID, false));
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// without a header page the free list is kept in memory only
+TEST(DiskManagerTest, FreePageNoHeaderTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<char> data(PAGE_SIZE, 'x');
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+    disk_manager->WritePage(i, data.data());
+  }
+  disk_manager->DeallocatePage(2);
+  EXPECT_EQ(2, disk_manager->AllocatePage());
+  EXPECT_EQ(4, disk_manager->AllocatePage());
+  disk_manager->DeallocatePage(1);
+  delete disk_manager;
+
+  // page 0 is untouched, new ids continue after the last page written
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(0, disk_manager->GetNumFreePages());
+  EXPECT_EQ(4, disk_manager->AllocatePage());
+  disk_manager->ReadPage(0, data.data());
+  EXPECT_EQ('x', data[DATA_SIZE - 1]);
+  EXPECT_EQ('x', data[8]);
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// allocations through two extents interleave, yet each extent's pages come
+// in runs of consecutive ids; what is left of the runs is freed on close
+// a db file of the format before page checksums, with the records of the
+// header page right after the record count, is refused
+TEST(DiskManagerTest, OldFormatTest) {
+  remove("test.db");
+  char page[PAGE_SIZE];
+  memset(page, 0, PAGE_SIZE);
+  int record_count = 1;
+  page_id_t root_id = 1;
+  memcpy(page, &record_count, 4);
+  strcpy(page + 4, "table");
+  memcpy(page + 36, &root_id, 4);
+  int fd = open("test.db", O_RDWR | O_CREAT, 0644);
+  ASSERT_LE(0, fd);
+  ASSERT_EQ(PAGE_SIZE, write(fd, page, PAGE_SIZE));
+  close(fd);
+  EXPECT_THROW(DiskManager("test.db"), Exception);
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, ExtentTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  page_id_t page_id;
+  HeaderPage *header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  ASSERT_NE(nullptr, header_page);
+  header_page->Init();
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  bpm->FlushPage(page_id);
+  delete bpm;
+
+  PageExtent a, b;
+  std::vector<page_id_t> pages_a, pages_b;
+  for (int i = 0; i < 20; ++i) {
+    pages_a.push_back(disk_manager->AllocatePage(&a));
+    pages_b.push_back(disk_manager->AllocatePage(&b));
+  }
+  // runs of 4, 8 and 16 pages
+  const page_id_t runs_a[] = {1, 9, 25};
+  const page_id_t runs_b[] = {5, 17, 41};
+  const int run_start[] = {0, 4, 12};
+  for (int r = 0; r < 3; ++r) {
+    for (int i = run_start[r]; i < 20 && i < run_start[r] + (4 << r); ++i) {
+      EXPECT_EQ(runs_a[r] + i - run_start[r], pages_a[i]);
+      EXPECT_EQ(runs_b[r] + i - run_start[r], pages_b[i]);
+    }
+  }
+  // single pages come after the runs
+  EXPECT_EQ(57, disk_manager->AllocatePage());
+  disk_manager->DeallocatePage(57);
+  delete disk_manager;
+
+  // 8 unused pages of each extent, and the single page that was freed; a
+  // new extent takes those before it gets a run, the ones of b came last
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(17, disk_manager->GetNumFreePages());
+  PageExtent c;
+  EXPECT_EQ(49, disk_manager->AllocatePage(&c));
+  for (int i = 0; i < 16; ++i) {
+    disk_manager->AllocatePage(&c);
+  }
+  EXPECT_EQ(0, disk_manager->GetNumFreePages());
+  EXPECT_EQ(58, disk_manager->AllocatePage(&c));
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// pages an extent owner deletes are reused by its next inserts, so the file
+// stops growing
+TEST(DiskManagerTest, ExtentReuseTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  page_id_t page_id;
+  HeaderPage *header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  ASSERT_NE(nullptr, header_page);
+  header_page->Init();
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+
+  PageExtent extent;
+  std::vector<page_id_t> pages;
+  page_id_t num_pages = 0;
+  for (int round = 0; round < 4; ++round) {
+    for (int i = 0; i < 40; ++i) {
+      Page *page = bpm->NewPage(page_id, &extent);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+      pages.push_back(page_id);
+    }
+    bpm->FlushAllPages();
+    // the second round still uses up what is left of the last run
+    if (round == 1) {
+      num_pages = disk_manager->GetNumPages();
+    }
+    if (round > 1) {
+      EXPECT_EQ(num_pages, disk_manager->GetNumPages());
+    }
+    for (page_id_t deleted : pages) {
+      EXPECT_EQ(true, bpm->DeletePage(deleted));
+    }
+    pages.clear();
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// the db file's page ids end where those of tablespace 1 begin: the last
+// ones are handed out, to a run that is cut short as well, then allocation
+// fails, for the buffer pool too, which keeps the pages in its frames
+TEST(DiskManagerTest, PageIdLimitTest) {
+  remove("test.db");
+  // a sparse file of all but the last 3 pages
+  int fd = open("test.db", O_RDWR | O_CREAT, 0644);
+  ASSERT_LE(0, fd);
+  off_t size = static_cast<off_t>(DiskManager::MAX_FILE_PAGES - 3) * PAGE_SIZE;
+  ASSERT_EQ(0, ftruncate(fd, size));
+  close(fd);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  const page_id_t last = DiskManager::MAX_FILE_PAGES - 1;
+  EXPECT_EQ(0, DiskManager::GetFileId(last));
+  EXPECT_EQ(last - 2, disk_manager->AllocatePage());
+  PageExtent a;
+  EXPECT_EQ(last - 1, disk_manager->AllocatePage(&a));
+  EXPECT_EQ(last, disk_manager->AllocatePage(&a));
+  EXPECT_EQ(INVALID_PAGE_ID, disk_manager->AllocatePage(&a));
+  EXPECT_EQ(INVALID_PAGE_ID, disk_manager->AllocatePage());
+
+  BufferPoolManager *bpm = new BufferPoolManager(2, disk_manager);
+  for (page_id_t page_id = last - 1; page_id <= last; ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, page_id == last));
+  }
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id));
+  for (page_id = last - 1; page_id <= last; ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+  }
+  EXPECT_EQ(2, bpm->GetStats().hits);
+  EXPECT_EQ(2, bpm->GetStats().misses);
+  EXPECT_EQ(0, bpm->GetStats().write_backs);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// a batch is written with one call per run of consecutive page ids and one
+// sync, and a checkpoint of adjacent dirty pages takes a handful of calls
+TEST(DiskManagerTest, WriteBatchTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  const int num_pages = 32;
+  std::vector<char> data(num_pages * PAGE_SIZE), buf(PAGE_SIZE);
+  for (int i = 0; i < num_pages; ++i) {
+    memset(&data[i * PAGE_SIZE], i + 1, PAGE_SIZE);
+  }
+
+  // one run: a single pwritev, then the sync
+  std::vector<DiskManager::PageWrite> batch;
+  for (int i = num_pages - 1; i >= 1; --i) {
+    batch.emplace_back(i, &data[i * PAGE_SIZE]);
+  }
+  uint64_t syscalls = disk_manager->GetNumIOSyscalls();
+  EXPECT_EQ(true, disk_manager->WritePages(batch, true));
+  EXPECT_EQ(syscalls + 2, disk_manager->GetNumIOSyscalls());
+  EXPECT_EQ(num_pages, disk_manager->GetNumPages());
+  for (int i = 1; i < num_pages; ++i) {
+    disk_manager->ReadPage(i, buf.data());
+    EXPECT_EQ(0, memcmp(&data[i * PAGE_SIZE], buf.data(), DATA_SIZE));
+  }
+
+  // three runs, written asynchronously
+  batch.clear();
+  const page_id_t page_ids[] = {40, 12, 41, 3, 13, 42, 14};
+  for (page_id_t page_id : page_ids) {
+    batch.emplace_back(page_id, &data[(page_id % num_pages) * PAGE_SIZE]);
+  }
+  syscalls = disk_manager->GetNumIOSyscalls();
+  EXPECT_EQ(true, disk_manager->WritePages(batch));
+  EXPECT_GE(syscalls + 3, disk_manager->GetNumIOSyscalls());
+  for (page_id_t page_id : page_ids) {
+    disk_manager->ReadPage(page_id, buf.data());
+    EXPECT_EQ(0, memcmp(&data[(page_id % num_pages) * PAGE_SIZE], buf.data(),
+                        DATA_SIZE));
+  }
+  delete disk_manager;
+  remove("test.db");
+
+  disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(num_pages, disk_manager);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    page->GetData()[0] = 'a';
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  syscalls = disk_manager->GetNumIOSyscalls();
+  bpm->FlushAllPages();
+  // page 0 and the rest of the pages, the sync
+  EXPECT_EQ(syscalls + 3, disk_manager->GetNumIOSyscalls());
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// a compressed file: pages of any compressibility come back as written,
+// also after moving to slots of another size and after a reopen
+TEST(DiskManagerTest, CompressedTest) {
+  const size_t page_size = 4096;
+  remove("test.db");
+  DiskManager *disk_manager =
+      new DiskManager("test.db", page_size, false, true);
+  ASSERT_EQ(true, disk_manager->IsCompressed());
+  std::mt19937 rng(3);
+  std::vector<std::vector<char>> pages(8, std::vector<char>(page_size, 0));
+  for (size_t i = 0; i < pages.size(); ++i) {
+    // half random, half mostly zeros
+    size_t random = i % 2 == 0 ? page_size : 100;
+    for (size_t j = 0; j < random; ++j) {
+      pages[i][j] = static_cast<char>(rng());
+    }
+    disk_manager->WritePage(i, pages[i].data());
+  }
+  // rewrite with the other kind of contents, the slots change size
+  std::swap(pages[2], pages[3]);
+  disk_manager->WritePage(2, pages[2].data());
+  disk_manager->WritePage(3, pages[3].data());
+  std::vector<DiskManager::PageWrite> batch = {{5, pages[4].data()},
+                                               {4, pages[5].data()}};
+  EXPECT_EQ(true, disk_manager->WritePages(batch, true));
+  std::swap(pages[4], pages[5]);
+  EXPECT_EQ(8, disk_manager->GetNumPages());
+  std::vector<char> buf(page_size);
+  const size_t data_size = page_size - PAGE_CHECKSUM_SIZE;
+  for (size_t i = 0; i < pages.size(); ++i) {
+    EXPECT_EQ(true, disk_manager->ReadPage(i, buf.data()));
+    EXPECT_EQ(0, memcmp(pages[i].data(), buf.data(), data_size));
+  }
+  // nothing written there yet
+  disk_manager->ReadPage(20, buf.data());
+  EXPECT_EQ(std::vector<char>(page_size, 0), buf);
+  delete disk_manager;
+
+  // the db file holds the 4 random pages and little more
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat("test.db", &stat_buf));
+  EXPECT_GT(5 * page_size, static_cast<size_t>(stat_buf.st_size));
+
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(true, disk_manager->IsCompressed());
+  EXPECT_EQ(page_size, disk_manager->GetPageSize());
+  for (size_t i = 0; i < pages.size(); ++i) {
+    memset(buf.data(), 1, page_size);
+    EXPECT_EQ(true, disk_manager->ReadPageAsync(i, buf.data()).get());
+    EXPECT_EQ(0, memcmp(pages[i].data(), buf.data(), data_size));
+  }
+  // freed space is reused: rewriting every page leaves the file as it was
+  for (size_t i = 0; i < pages.size(); ++i) {
+    disk_manager->WritePage(i, pages[(i + 1) % pages.size()].data());
+  }
+  delete disk_manager;
+  struct stat stat_after;
+  ASSERT_EQ(0, stat("test.db", &stat_after));
+  EXPECT_EQ(stat_buf.st_size, stat_after.st_size);
+  remove("test.db");
+
+  // a file made uncompressed stays that way
+  disk_manager = new DiskManager("test.db");
+  disk_manager->WritePage(1, pages[0].data());
+  delete disk_manager;
+  disk_manager = new DiskManager("test.db", PAGE_SIZE, false, true);
+  EXPECT_EQ(false, disk_manager->IsCompressed());
+  delete disk_manager;
+  remove("test.db");
+  remove("test.map");
+  remove("test.log");
+}
+
+// with tablespaces every extent gets a file of its own, where its pages are
+// numbered from 1 after the file's header; a batch writes and syncs the files
+// it touches; the files, their free lists and page counts are found again
+// after a reopen, and a dropped one is gone
+TEST(DiskManagerTest, TablespaceTest) {
+  remove("test.db");
+  DiskManager *disk_manager =
+      new DiskManager("test.db", PAGE_SIZE, false, false, true);
+  PageExtent a, b;
+  std::vector<page_id_t> pages;
+  for (int i = 0; i < 4; ++i) {
+    pages.push_back(disk_manager->AllocatePage(&a));
+    pages.push_back(disk_manager->AllocatePage(&b));
+    EXPECT_EQ(DiskManager::MakePageId(1, i + 1), pages[2 * i]);
+    EXPECT_EQ(DiskManager::MakePageId(2, i + 1), pages[2 * i + 1]);
+  }
+  // pages without an extent stay in the db file
+  EXPECT_EQ(HEADER_PAGE_ID, disk_manager->AllocatePage());
+  struct stat stat_buf;
+  EXPECT_EQ(0, stat("test_1.db", &stat_buf));
+  EXPECT_EQ(0, stat("test_2.db", &stat_buf));
+
+  std::vector<char> data(pages.size() * PAGE_SIZE), buf(PAGE_SIZE);
+  std::vector<DiskManager::PageWrite> batch;
+  for (size_t i = 0; i < pages.size(); ++i) {
+    memset(&data[i * PAGE_SIZE], 'a' + i, PAGE_SIZE);
+    batch.emplace_back(pages[i], &data[i * PAGE_SIZE]);
+  }
+  batch.emplace_back(HEADER_PAGE_ID, &data[0]);
+  uint64_t syscalls = disk_manager->GetNumIOSyscalls();
+  EXPECT_EQ(true, disk_manager->WritePages(batch, true));
+  // one write and one sync for each file at most
+  EXPECT_GE(syscalls + 6, disk_manager->GetNumIOSyscalls());
+  EXPECT_EQ(1, disk_manager->GetNumPages());
+  EXPECT_EQ(5, disk_manager->GetNumPages(1));
+  EXPECT_EQ(5, disk_manager->GetNumPages(2));
+  for (size_t i = 0; i < pages.size(); ++i) {
+    EXPECT_EQ(true, disk_manager->ReadPage(pages[i], buf.data()));
+    EXPECT_EQ(static_cast<char>('a' + i), buf[0]);
+  }
+  // a freed page is reused in its file, not in others
+  disk_manager->DeallocatePage(pages[2]);
+  EXPECT_EQ(1, disk_manager->GetNumFreePages(1));
+  EXPECT_EQ(0, disk_manager->GetNumFreePages(2));
+  EXPECT_EQ(pages[2], disk_manager->AllocatePage(&a));
+  disk_manager->DeallocatePage(pages[4]);
+  // a page handed out but never written
+  EXPECT_EQ(DiskManager::MakePageId(2, 5), disk_manager->AllocatePage(&b));
+  delete disk_manager;
+
+  // tablespaces or not, the pages are there, and an owner that has some
+  // adds to its file: free pages first, then after every page handed out
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(true, disk_manager->ReadPage(pages[7], buf.data()));
+  EXPECT_EQ('h', buf[0]);
+  EXPECT_EQ(true, disk_manager->ReadPageAsync(pages[6], buf.data()).get());
+  EXPECT_EQ('g', buf[0]);
+  EXPECT_EQ(1, disk_manager->GetNumFreePages(1));
+  PageExtent c, d;
+  c.SetFileOf(pages[1]);
+  d.SetFileOf(pages[0]);
+  EXPECT_EQ(DiskManager::MakePageId(2, 6), disk_manager->AllocatePage(&c));
+  EXPECT_EQ(pages[4], disk_manager->AllocatePage(&d));
+  EXPECT_EQ(DiskManager::MakePageId(1, 5), disk_manager->AllocatePage(&d));
+  EXPECT_EQ(0, disk_manager->GetNumFreePages(1));
+  EXPECT_EQ(true, disk_manager->DropFile(1));
+  EXPECT_NE(0, stat("test_1.db", &stat_buf));
+  EXPECT_EQ(false, disk_manager->ReadPage(pages[0], buf.data()));
+  EXPECT_EQ(false, disk_manager->DropFile(1));
+  delete disk_manager;
+
+  // a new db file starts without the tablespaces of an old one
+  remove("test.db");
+  disk_manager = new DiskManager("test.db");
+  EXPECT_NE(0, stat("test_2.db", &stat_buf));
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// a page changed in the file behind the disk manager's back fails its
+// checksum, by any path it is read; pages never written pass as zeros
+TEST(DiskManagerTest, ChecksumTest) {
+  for (int compress = 0; compress < 2; ++compress) {
+    remove("test.db");
+    remove("test.map");
+    DiskManager *disk_manager =
+        new DiskManager("test.db", PAGE_SIZE, false, compress);
+    std::vector<char> data(PAGE_SIZE, 'c'), buf(PAGE_SIZE);
+    disk_manager->WritePage(1, data.data());
+    disk_manager->WritePage(3, data.data());
+    std::vector<DiskManager::PageWrite> batch = {{4, data.data()},
+                                                 {5, data.data()}};
+    EXPECT_EQ(true, disk_manager->WritePages(batch));
+    for (page_id_t page_id = 0; page_id < 6; ++page_id) {
+      EXPECT_EQ(true, disk_manager->ReadPage(page_id, buf.data()));
+      EXPECT_EQ(true, disk_manager->ReadPageAsync(page_id, buf.data()).get());
+    }
+    EXPECT_EQ(0, disk_manager->GetNumChecksumFailures());
+
+    // flip a bit in the data of page 3 and in the checksum of page 4. A
+    // compressed page of one byte repeated fits a slot of one unit, the
+    // slots follow the order of the writes, and the byte after the token is
+    // the page's first byte
+    off_t offsets[] = {3 * PAGE_SIZE + 100, 4 * PAGE_SIZE + DATA_SIZE + 1};
+    if (compress) {
+      offsets[0] = CompressedPageFile::SLOT_SIZE + 1;
+      offsets[1] = 2 * CompressedPageFile::SLOT_SIZE + 1;
+    }
+    int fd = open("test.db", O_RDWR);
+    ASSERT_LE(0, fd);
+    for (off_t offset : offsets) {
+      char byte;
+      ASSERT_EQ(1, pread(fd, &byte, 1, offset));
+      byte ^= 0x10;
+      ASSERT_EQ(1, pwrite(fd, &byte, 1, offset));
+    }
+    close(fd);
+    int failed = 0;
+    for (page_id_t page_id = 0; page_id < 6; ++page_id) {
+      failed += !disk_manager->ReadPage(page_id, buf.data());
+      failed += !disk_manager->ReadPageAsync(page_id, buf.data()).get();
+    }
+    EXPECT_EQ(4, failed);
+    EXPECT_EQ(4, disk_manager->GetNumChecksumFailures());
+    // written again, it is whole again
+    disk_manager->WritePage(3, data.data());
+    EXPECT_EQ(true, disk_manager->ReadPage(3, buf.data()));
+    delete disk_manager;
+  }
+  remove("test.db");
+  remove("test.map");
+  remove("test.log");
+}
+
+// with direct I/O, aligned and unaligned page data both go through, and the
+// file reads the same buffered afterwards
+TEST(DiskManagerTest, DirectIOTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db", PAGE_SIZE, true);
+  if (!disk_manager->IsDirectIO()) {
+    printf("O_DIRECT not supported here, testing the buffered fallback\n");
+    EXPECT_EQ(1U, disk_manager->GetIOAlignment());
+  } else {
+    printf("O_DIRECT with %zu byte aligned buffers\n",
+           disk_manager->GetIOAlignment());
+  }
+  AlignedBuffer aligned(PAGE_SIZE, PAGE_SIZE);
+  std::vector<char> storage(PAGE_SIZE + 1), buf(PAGE_SIZE);
+  char *unaligned = storage.data() + 1;
+
+  memset(aligned.GetData(), 'a', PAGE_SIZE);
+  disk_manager->WritePage(0, aligned.GetData());
+  memset(unaligned, 'u', PAGE_SIZE);
+  disk_manager->WritePage(1, unaligned);
+  const char *pages[] = {unaligned, aligned.GetData()};
+  disk_manager->WritePages(2, pages, 2);
+  memset(unaligned, 'w', PAGE_SIZE);
+  EXPECT_EQ(true, disk_manager->WritePageAsync(4, unaligned).get());
+  EXPECT_EQ(5, disk_manager->GetNumPages());
+
+  const char expected[] = {'a', 'u', 'u', 'a', 'w'};
+  for (page_id_t page_id = 0; page_id < 5; ++page_id) {
+    disk_manager->ReadPage(page_id, unaligned);
+    EXPECT_EQ(expected[page_id], unaligned[DATA_SIZE - 1]);
+    memset(unaligned, 0, PAGE_SIZE);
+    EXPECT_EQ(true, disk_manager->ReadPageAsync(page_id, unaligned).get());
+    EXPECT_EQ(expected[page_id], unaligned[0]);
+    disk_manager->ReadPage(page_id, aligned.GetData());
+    EXPECT_EQ(0, memcmp(unaligned, aligned.GetData(), PAGE_SIZE));
+  }
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(false, disk_manager->IsDirectIO());
+  for (page_id_t page_id = 0; page_id < 5; ++page_id) {
+    disk_manager->ReadPage(page_id, buf.data());
+    EXPECT_EQ(expected[page_id], buf[PAGE_SIZE / 2]);
+  }
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// bytes of the file held in the kernel page cache
+static size_t PageCacheResident(const char *file_name, size_t size) {
+  int fd = open(file_name, O_RDONLY);
+  void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return 0;
+  }
+  size_t os_page = sysconf(_SC_PAGESIZE);
+  std::vector<unsigned char> vec((size + os_page - 1) / os_page);
+  size_t resident = 0;
+  if (mincore(map, size, vec.data()) == 0) {
+    for (unsigned char v : vec) {
+      resident += (v & 1) * os_page;
+    }
+  }
+  munmap(map, size);
+  return resident;
+}
+
+// random page fetches through a buffer pool smaller than the file, buffered
+// and with O_DIRECT, starting with nothing cached. Buffered reads leave a
+// second copy of every page they touch in the page cache; direct reads keep
+// the buffer pool the only copy, at the price of going to the device on
+// every miss
+TEST(DiskManagerTest, DirectIOBenchmark) {
+  const int num_pages = 16384;
+  const size_t pool_size = 1024;
+  const int num_fetches = 2 * num_pages;
+  const size_t file_size = static_cast<size_t>(num_pages) * PAGE_SIZE;
+  size_t resident[2] = {0, 0};
+  printf("%-9s %12s %14s %14s\n", "mode", "fetches/s", "pool (MB)",
+         "page cache (MB)");
+  for (int direct = 0; direct < 2; ++direct) {
+    remove("test.db");
+    DiskManager *disk_manager = new DiskManager("test.db", PAGE_SIZE, direct);
+    if (direct && !disk_manager->IsDirectIO()) {
+      printf("O_DIRECT not supported here, skipped\n");
+      delete disk_manager;
+      break;
+    }
+    const int run = 64;
+    AlignedBuffer data(run * PAGE_SIZE, PAGE_SIZE);
+    std::vector<const char *> pages(run);
+    for (int i = 0; i < run; ++i) {
+      pages[i] = data.GetData() + i * PAGE_SIZE;
+    }
+    for (int i = 0; i < num_pages; i += run) {
+      for (int j = 0; j < run; ++j) {
+        memset(data.GetData() + j * PAGE_SIZE, (i + j) % 127, PAGE_SIZE);
+      }
+      disk_manager->WritePages(i, pages.data(), run);
+    }
+    // start cold: drop what the writes left in the page cache
+    int fd = open("test.db", O_RDONLY);
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+
+    BufferPoolManager *bpm = new BufferPoolManager(pool_size, disk_manager);
+    std::mt19937 rng(7);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_fetches; ++i) {
+      page_id_t page_id = rng() % num_pages;
+      Page *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(page_id % 127, page->GetData()[DATA_SIZE - 1]);
+      bpm->UnpinPage(page_id, false);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    resident[direct] = PageCacheResident("test.db", file_size);
+    printf("%-9s %12.0f %14.1f %14.1f\n", direct ? "O_DIRECT" : "buffered",
+           num_fetches / elapsed.count(), pool_size * PAGE_SIZE / 1048576.0,
+           resident[direct] / 1048576.0);
+
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+  // direct reads do not fill the page cache
+  EXPECT_LE(resident[1], resident[0]);
+}
+
+// page writes and reads, each computing a checksum, against computing the
+// checksums alone: the share of page I/O time the checksums take, for small
+// and large pages, buffered (every read a page cache hit) and with O_DIRECT
+TEST(DiskManagerTest, ChecksumBenchmark) {
+  const int num_pages = 2048;
+  const int rounds = 4;
+  std::mt19937 rng(9);
+  printf("crc32 instruction: %s\n", Crc32cHasHardware() ? "yes" : "no");
+  printf("%-9s %6s %14s %14s %10s\n", "mode", "page", "page I/O (us)",
+         "checksum (us)", "overhead");
+  for (size_t page_size : {static_cast<size_t>(PAGE_SIZE), size_t{4096}}) {
+    for (int direct = 0; direct < 2; ++direct) {
+      remove("test.db");
+      DiskManager *disk_manager = new DiskManager("test.db", page_size, direct);
+      if (direct && !disk_manager->IsDirectIO()) {
+        printf("O_DIRECT not supported here, skipped\n");
+        delete disk_manager;
+        continue;
+      }
+      AlignedBuffer page(page_size, page_size);
+      for (size_t i = 0; i < page_size; ++i) {
+        page.GetData()[i] = static_cast<char>(rng());
+      }
+      auto start = std::chrono::steady_clock::now();
+      for (int round = 0; round < rounds; ++round) {
+        for (int i = 0; i < num_pages; ++i) {
+          disk_manager->WritePage(i, page.GetData());
+        }
+        for (int i = 0; i < num_pages; ++i) {
+          ASSERT_EQ(true, disk_manager->ReadPage(i, page.GetData()));
+        }
+      }
+      std::chrono::duration<double> io =
+          std::chrono::steady_clock::now() - start;
+      // one checksum per write and one per read
+      volatile uint32_t sink = 0;
+      start = std::chrono::steady_clock::now();
+      for (int i = 0; i < 2 * rounds * num_pages; ++i) {
+        sink = sink + Crc32c(page.GetData(), page_size - PAGE_CHECKSUM_SIZE);
+      }
+      std::chrono::duration<double> checksum =
+          std::chrono::steady_clock::now() - start;
+      double transfers = 2.0 * rounds * num_pages;
+      printf("%-9s %6zu %14.2f %14.3f %9.2f%%\n",
+             direct ? "O_DIRECT" : "buffered", page_size,
+             io.count() * 1e6 / transfers, checksum.count() * 1e6 / transfers,
+             100 * checksum.count() / (io.count() - checksum.count()));
+      EXPECT_EQ(0, disk_manager->GetNumChecksumFailures());
+      delete disk_manager;
+    }
+  }
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace scudb
@@ -0,0 +1,71 @@
+/**
+ * page_compression_test.cpp
+ */
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "disk/page_compression.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+// compress and decompress, the block must come back as it was
+static size_t RoundTrip(const std::vector<char> &data) {
+  // room for the worst case, all literals
+  std::vector<char> block(data.size() + data.size() / 255 + 16);
+  std::vector<char> out(data.size());
+  size_t size =
+      CompressBlock(data.data(), data.size(), block.data(), block.size());
+  EXPECT_LT(0U, size);
+  EXPECT_EQ(true, DecompressBlock(block.data(), size, out.data(), out.size()));
+  EXPECT_EQ(data, out);
+  return size;
+}
+
+TEST(PageCompressionTest, RoundTripTest) {
+  std::mt19937 rng(7);
+  // zeros, random bytes, text with repeats, and tiny blocks
+  std::vector<char> zeros(4096, 0);
+  EXPECT_GT(100U, RoundTrip(zeros));
+  std::vector<char> random(4096);
+  for (auto &c : random) {
+    c = static_cast<char>(rng());
+  }
+  RoundTrip(random);
+  std::string text;
+  const char *words[] = {"select ", "from ", "where ", "table ", "page "};
+  while (text.size() < 4096) {
+    text += words[rng() % 5];
+  }
+  std::vector<char> words_page(text.begin(), text.begin() + 4096);
+  EXPECT_GT(2048U, RoundTrip(words_page));
+  for (size_t size = 1; size < 20; ++size) {
+    RoundTrip(std::vector<char>(size, 'x'));
+  }
+  // a match of more than 15 + 255 bytes, a literal run of as many
+  std::vector<char> mixed(random.begin(), random.begin() + 600);
+  mixed.insert(mixed.end(), 600, 'y');
+  RoundTrip(mixed);
+
+  // no room: 0, and the decompression of any bytes stays in bounds
+  std::vector<char> block(64), out(4096);
+  EXPECT_EQ(0U, CompressBlock(random.data(), random.size(), block.data(),
+                              block.size()));
+  for (int i = 0; i < 1000; ++i) {
+    for (auto &c : block) {
+      c = static_cast<char>(rng());
+    }
+    DecompressBlock(block.data(), 1 + rng() % block.size(), out.data(),
+                    out.size());
+  }
+  size_t size = CompressBlock(words_page.data(), words_page.size(), out.data(),
+                              out.size());
+  std::vector<char> page(4096);
+  EXPECT_EQ(false, DecompressBlock(out.data(), size / 2, page.data(), 4096));
+  EXPECT_EQ(false, DecompressBlock(out.data(), size, page.data(), 4095));
+}
+
+} // namespace scudb
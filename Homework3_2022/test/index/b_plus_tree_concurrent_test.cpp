@@ -150,6 +150,23 @@ void DeleteHelperSplit(
   delete transaction;
 }
 
+// helper function to look keys up, all of them must be found
+void LookupHelper(BPlusTree<GenericKey<16>, RID, GenericComparator<16>> &tree,
+                  const std::vector<int64_t> &keys, int rounds,
+                  __attribute__((unused)) uint64_t thread_itr = 0) {
+  GenericKey<16> index_key;
+  Transaction *transaction = new Transaction(0);
+  for (int round = 0; round < rounds; ++round) {
+    for (auto key : keys) {
+      std::vector<RID> rids;
+      index_key.SetFromInteger(key);
+      EXPECT_EQ(true, tree.GetValue(index_key, rids, transaction));
+      EXPECT_EQ(key & 0xFFFFFFFF, rids[0].GetSlotNum());
+    }
+  }
+  delete transaction;
+}
+
 TEST(BPlusTreeConcurrentTest, InsertTest1) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
@@ -201,8 +218,8 @@ TEST(BPlusTreeConcurrentTest, InsertTest1) {
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   EXPECT_TRUE(tree.Check(true));
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -256,8 +273,8 @@ TEST(BPlusTreeConcurrentTest, InsertTest2) {
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   EXPECT_TRUE(tree.Check(true));
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -313,8 +330,8 @@ TEST(BPlusTreeConcurrentTest, InsertAndGetTest) {
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   EXPECT_TRUE(tree.Check(true));
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -360,8 +377,8 @@ TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   EXPECT_TRUE(tree.Check(true));
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -406,8 +423,8 @@ TEST(BPlusTreeConcurrentTest, DeleteAndGetTest) {
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   EXPECT_TRUE(tree.Check(true));
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -453,8 +470,8 @@ TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   EXPECT_TRUE(tree.Check(true));
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -503,8 +520,8 @@ TEST(BPlusTreeConcurrentTest, DeleteTest3) {
   EXPECT_TRUE(tree.Check(true));
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
 }
 
@@ -554,8 +571,8 @@ TEST(BPlusTreeConcurrentTest, DeleteTest4) {
   EXPECT_TRUE(tree.Check(true));
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
 }
 
@@ -657,8 +674,8 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   EXPECT_TRUE(tree.Check(true));
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -722,8 +739,8 @@ TEST(BPlusTreeConcurrentTest, MixTest2) {
   EXPECT_TRUE(tree.Check(true));
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -817,8 +834,48 @@ TEST(BPlusTreeConcurrentTest, MixTest3) {
   EXPECT_TRUE(tree.Check(true));
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete key_schema;
+  delete bpm;
   delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// readers descend optimistically while writers split and merge the pages
+// they pass through; a reader must never take a wrong turn
+TEST(BPlusTreeConcurrentTest, OptimisticReadTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<16> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<16>, RID, GenericComparator<16>> tree("foo_pk", bpm,
+                                                             comparator);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void) header_page;
+
+  // even keys stay, odd keys come and go
+  std::vector<int64_t> stable, moving;
+  for (int64_t key = 1; key <= 2000; ++key) {
+    (key % 2 == 0 ? stable : moving).push_back(key);
+  }
+  InsertHelper(tree, stable);
+
+  std::thread r0(LookupHelper, std::ref(tree), stable, 3, 0);
+  std::thread r1(LookupHelper, std::ref(tree), stable, 3, 1);
+  std::thread w0(InsertHelper, std::ref(tree), moving, 0);
+  w0.join();
+  std::thread w1(DeleteHelper, std::ref(tree), moving, 0);
+  w1.join();
+  r0.join();
+  r1.join();
+
+  LookupHelper(tree, stable, 1);
+  EXPECT_TRUE(tree.Check(true));
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -94,8 +94,8 @@ TEST(BPlusTreeDeleteTests, DeleteTest1) {
   ASSERT_TRUE(bpm->CheckAllUnpined());
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   delete key_schema;
   remove("test.db");
   remove("test.log");
@@ -176,8 +176,8 @@ TEST(BPlusTreeDeleteTests, DeleteTest2) {
   ASSERT_TRUE(bpm->CheckAllUnpined());
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   delete key_schema;
   remove("test.db");
   remove("test.log");
@@ -252,8 +252,8 @@ TEST(BPlusTreeDeleteTests, DeleteBasic) {
   ASSERT_TRUE(bpm->CheckAllUnpined());
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   delete key_schema;
   remove("test.db");
   remove("test.log");
@@ -338,8 +338,8 @@ TEST(BPlusTreeDeleteTests, DeleteScale) {
   
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   delete key_schema;
   remove("test.db");
   remove("test.log");
@@ -388,8 +388,8 @@ TEST(BPlusTreeDeleteTests, DeleteRandom) {
   ASSERT_TRUE(tree.Check(true));
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   delete key_schema;
   remove("test.db");
   remove("test.log");
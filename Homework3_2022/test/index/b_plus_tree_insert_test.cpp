@@ -10,6 +10,7 @@
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
 #include "index/b_plus_tree.h"
+#include "page/header_page.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
 
@@ -72,8 +73,8 @@ TEST(BPlusTreeInsertTests, InsertTest1) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   delete key_schema;
   remove("test.db");
   remove("test.log");
@@ -144,8 +145,8 @@ TEST(BPlusTreeInsertTests, InsertTest2) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   delete key_schema;
   remove("test.db");
   remove("test.log");
@@ -215,8 +216,68 @@ TEST(BPlusTreeInsertTests, InsertScale) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
+  delete bpm;
   delete disk_manager;
+  delete key_schema;
+  remove("test.db");
+  remove("test.log");
+}
+
+// the same tree on 16 KiB pages: nodes take what fits into the larger page
+TEST(BPlusTreeInsertTests, InsertLargePage) {
+  remove("test.db");
+  remove("test.log");
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<16> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db", 16384);
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  EXPECT_EQ(16384, bpm->GetPageSize());
+  BPlusTree<GenericKey<16>, RID, GenericComparator<16>> tree("foo_pk", bpm,
+                                                             comparator);
+  GenericKey<16> index_key;
+  RID rid;
+  Transaction *transaction = new Transaction(0);
+
+  page_id_t page_id;
+  auto header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  header_page->Init();
+
+  int scale = 5000;
+  page_id_t root_id;
+  for (int64_t key = 1; key <= scale; ++key) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+    if (key == 500) {
+      // 500 entries still fit into the first leaf
+      EXPECT_EQ(true, header_page->GetRootId("foo_pk", root_id));
+      EXPECT_EQ(1, root_id);
+    }
+  }
+
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= scale; ++key) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, rids);
+    EXPECT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  int64_t current_key = 1;
+  index_key.SetFromInteger(current_key);
+  for (auto iterator = tree.Begin(index_key); iterator.isEnd() == false;
+       ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, scale + 1);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
   delete bpm;
+  delete disk_manager;
   delete key_schema;
   remove("test.db");
   remove("test.log");
@@ -286,8 +347,8 @@ TEST(BPlusTreeInsertTests, InsertReverse) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   delete key_schema;
   remove("test.db");
   remove("test.log");
@@ -359,8 +420,8 @@ TEST(BPlusTreeInsertTests, InsertRandom) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   delete key_schema;
   remove("test.db");
   remove("test.log");
@@ -39,7 +39,7 @@ TEST(BPlusTreePageTests, testInternalPage) {
   bpm->NewPage(p4);
 
   BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>> *ip = reinterpret_cast<BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>> *>(root_page->GetData());
-  ip->Init(root_page_id);
+  ip->Init(root_page_id, INVALID_PAGE_ID, root_page->GetUsableSize());
   ip->SetMaxSize(4);
   index_key.SetFromInteger(1);
   ip->PopulateNewRoot(p0, index_key, p1);
@@ -92,8 +92,8 @@ TEST(BPlusTreePageTests, testInternalPage) {
   bpm->UnpinPage(p2, true);
   bpm->UnpinPage(p3, true);
   bpm->UnpinPage(p4, true);
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   delete key_schema;
   remove("test.db");
   remove("test.log");
@@ -107,7 +107,7 @@ TEST(BPlusTreePageTests, testLeafPage) {
   RID rid;
 
   BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>> *leaf = reinterpret_cast<BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>> *>(leaf_ptr);
-  leaf->Init(1);
+  leaf->Init(1, INVALID_PAGE_ID, 300);
   leaf->SetMaxSize(4);
 
   // 测试Insert(), KeyIndex()
@@ -139,7 +139,7 @@ TEST(BPlusTreePageTests, testLeafPage) {
   leaf->Insert(index_key, rid, comparator);
   char *new_leaf_ptr = new char[300];
   BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>> *new_leaf = reinterpret_cast<BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>> *>(new_leaf_ptr);
-  new_leaf->Init(2);
+  new_leaf->Init(2, INVALID_PAGE_ID, 300);
   new_leaf->SetMaxSize(4);
   leaf->MoveHalfTo(new_leaf, nullptr);
   EXPECT_EQ(2, leaf->GetSize());
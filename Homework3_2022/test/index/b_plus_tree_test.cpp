@@ -92,8 +92,8 @@ TEST(BPlusTreeTests, ScaleTest) {
   ASSERT_TRUE(tree.Check(true));
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -178,8 +178,8 @@ TEST(BPlusTreeTests, RandomTest) {
   ASSERT_TRUE(tree.Check(true));
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
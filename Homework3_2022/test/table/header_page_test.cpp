@@ -2,15 +2,15 @@
 #include <cstdlib>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
 #include "page/header_page.h"
 #include "gtest/gtest.h"
 
-// NOTE: when you running this test, make sure page size(config.h) is at least
-// 4096
 namespace scudb {
 
 TEST(HeaderPageTest, UnitTest) {
-  DiskManager *disk_manager = new DiskManager("test.db");
+  // 27 records need more than the default page size
+  DiskManager *disk_manager = new DiskManager("test.db", 4096);
   BufferPoolManager *buffer_pool_manager =
       new BufferPoolManager(20, disk_manager);
   page_id_t header_page_id;
@@ -55,4 +55,45 @@ TEST(HeaderPageTest, UnitTest) {
   remove("test.db");
   remove("test.log");
 }
+
+// the header page records the page size, a reopened file keeps it
+TEST(HeaderPageTest, PageSizeTest) {
+  remove("test.db");
+  remove("test.log");
+  DiskManager *disk_manager = new DiskManager("test.db", 8192);
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(10, disk_manager);
+  page_id_t header_page_id;
+  HeaderPage *page =
+      static_cast<HeaderPage *>(buffer_pool_manager->NewPage(header_page_id));
+  page->Init();
+  EXPECT_EQ((8192 - HeaderPage::PREFIX_SIZE) / 36, page->GetMaxRecordCount());
+  for (int i = 0; i < page->GetMaxRecordCount(); i++) {
+    EXPECT_EQ(true, page->InsertRecord(std::to_string(i), i + 1));
+  }
+  // full
+  EXPECT_EQ(false, page->InsertRecord("one too many", 1));
+  buffer_pool_manager->UnpinPage(header_page_id, true);
+  buffer_pool_manager->FlushPage(header_page_id);
+  delete buffer_pool_manager;
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(8192, disk_manager->GetPageSize());
+  buffer_pool_manager = new BufferPoolManager(10, disk_manager);
+  page = static_cast<HeaderPage *>(
+      buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+  EXPECT_EQ((8192 - HeaderPage::PREFIX_SIZE) / 36, page->GetRecordCount());
+  page_id_t root_id;
+  EXPECT_EQ(true, page->GetRootId("100", root_id));
+  EXPECT_EQ(101, root_id);
+  buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, false);
+  delete buffer_pool_manager;
+  delete disk_manager;
+
+  EXPECT_THROW(DiskManager("test.db", 1000), Exception);
+  EXPECT_THROW(DiskManager("test.db", 2 * MAX_PAGE_SIZE), Exception);
+  remove("test.db");
+  remove("test.log");
+}
 } // namespace scudb
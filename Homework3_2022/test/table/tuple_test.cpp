@@ -3,9 +3,13 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <random>
 #include <string>
+#include <sys/stat.h>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
@@ -61,4 +65,224 @@ TEST(TupleTest, TableHeapTest) {
   delete disk_manager;
 }
 
+// two tables filled at the same time still get runs of consecutive pages
+TEST(TupleTest, TableHeapExtentTest) {
+  Schema *schema = ParseCreateStatement("a varchar, b bigint");
+  Tuple tuple = ConstructTuple(schema);
+  Transaction *transaction = new Transaction(0);
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(50, disk_manager);
+  LockManager *lock_manager = new LockManager(true);
+  LogManager *log_manager = new LogManager(disk_manager);
+  TableHeap *tables[2];
+  for (auto &table : tables) {
+    table = new TableHeap(buffer_pool_manager, lock_manager, log_manager,
+                          transaction);
+  }
+
+  RID rid;
+  for (int i = 0; i < 2000; ++i) {
+    EXPECT_EQ(true, tables[i % 2]->InsertTuple(tuple, rid, transaction));
+  }
+  for (auto table : tables) {
+    // follow the page chain, counting the steps to the next page id
+    int pages = 0, sequential = 0;
+    page_id_t page_id = table->GetFirstPageId();
+    while (page_id != INVALID_PAGE_ID) {
+      auto page = static_cast<TablePage *>(
+          buffer_pool_manager->FetchPage(page_id));
+      page_id_t next_page_id = page->GetNextPageId();
+      buffer_pool_manager->UnpinPage(page_id, false);
+      pages++;
+      sequential += next_page_id == page_id + 1;
+      page_id = next_page_id;
+    }
+    EXPECT_LT(12, pages);
+    // a jump only where a run of 4, 8, 16... pages ends, and at the end
+    int runs = 0;
+    int size = DiskManager::MIN_EXTENT_PAGES;
+    for (int covered = 0; covered < pages; covered += size) {
+      if (runs++ > 0) {
+        size = std::min(2 * size, DiskManager::MAX_EXTENT_PAGES);
+      }
+    }
+    EXPECT_EQ(pages - runs, sequential);
+    delete table;
+  }
+
+  delete schema;
+  delete transaction;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// with tablespaces each table lives in a file of its own, where a reopened
+// table keeps adding pages, and dropping the file takes the table's pages
+// out of the buffer pool too
+TEST(TupleTest, TableHeapTablespaceTest) {
+  Schema *schema = ParseCreateStatement("a varchar, b bigint");
+  Tuple tuple = ConstructTuple(schema);
+  Transaction *transaction = new Transaction(0);
+  remove("test.db");
+  DiskManager *disk_manager =
+      new DiskManager("test.db", PAGE_SIZE, false, false, true);
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(50, disk_manager);
+  LockManager *lock_manager = new LockManager(true);
+  LogManager *log_manager = new LogManager(disk_manager);
+  TableHeap *tables[2];
+  for (auto &table : tables) {
+    table = new TableHeap(buffer_pool_manager, lock_manager, log_manager,
+                          transaction);
+  }
+  RID rid;
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(true, tables[i % 2]->InsertTuple(tuple, rid, transaction));
+  }
+  page_id_t first_page_id = tables[1]->GetFirstPageId();
+  EXPECT_EQ(1, DiskManager::GetFileId(tables[0]->GetFirstPageId()));
+  EXPECT_EQ(2, DiskManager::GetFileId(first_page_id));
+  delete tables[1];
+  buffer_pool_manager->FlushAllPages();
+  page_id_t num_pages = disk_manager->GetNumPages(2);
+  EXPECT_LT(4, num_pages);
+
+  tables[1] = new TableHeap(buffer_pool_manager, lock_manager, log_manager,
+                            first_page_id);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(true, tables[1]->InsertTuple(tuple, rid, transaction));
+    EXPECT_EQ(2, DiskManager::GetFileId(rid.GetPageId()));
+  }
+  int count = 0;
+  for (auto itr = tables[1]->begin(transaction); itr != tables[1]->end();
+       ++itr) {
+    count++;
+  }
+  EXPECT_EQ(1500, count);
+  buffer_pool_manager->FlushAllPages();
+  EXPECT_LT(num_pages, disk_manager->GetNumPages(2));
+
+  // pinned pages keep the file
+  EXPECT_NE(nullptr, buffer_pool_manager->FetchPage(first_page_id));
+  EXPECT_EQ(false, buffer_pool_manager->DropFile(2));
+  buffer_pool_manager->UnpinPage(first_page_id, false);
+  delete tables[1];
+  EXPECT_EQ(true, buffer_pool_manager->DropFile(2));
+  struct stat stat_buf;
+  EXPECT_NE(0, stat("test_2.db", &stat_buf));
+  // the other table is untouched
+  count = 0;
+  for (auto itr = tables[0]->begin(transaction); itr != tables[0]->end();
+       ++itr) {
+    count++;
+  }
+  EXPECT_EQ(500, count);
+
+  delete tables[0];
+  delete schema;
+  delete transaction;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test_1.db");
+  remove("test.log");
+}
+
+// a table of customer rows stored raw and compressed: size of the files
+// after a checkpoint, and full scans through a buffer pool far smaller than
+// the table, so nearly every page comes from the file (and is decompressed)
+TEST(TupleTest, TableHeapCompressionBenchmark) {
+  const size_t page_size = 4096;
+  const int num_tuples = 30000;
+  const int num_scans = 5;
+  const char *cities[] = {"Chengdu", "Beijing",  "Shanghai", "Shenzhen",
+                          "Wuhan",   "Hangzhou", "Nanjing",  "Chongqing"};
+  Schema *schema = ParseCreateStatement(
+      "id int, name varchar, city varchar, balance bigint, active bool");
+  Transaction *transaction = new Transaction(0);
+  LockManager *lock_manager = new LockManager(true);
+  int64_t file_size[2];
+  double scan_rate[2];
+  for (int compress = 0; compress < 2; ++compress) {
+    remove("test.db");
+    remove("test.map");
+    DiskManager *disk_manager =
+        new DiskManager("test.db", page_size, false, compress);
+    LogManager *log_manager = new LogManager(disk_manager);
+    // inserts walk the page chain, the table has to fit in the pool
+    BufferPoolManager *buffer_pool_manager =
+        new BufferPoolManager(1024, disk_manager);
+    TableHeap *table = new TableHeap(buffer_pool_manager, lock_manager,
+                                     log_manager, transaction);
+    std::mt19937 rng(11);
+    RID rid;
+    for (int i = 0; i < num_tuples; ++i) {
+      std::string name = "customer#" + std::to_string(100000 + rng() % 900000);
+      const char *city = cities[rng() % 8];
+      std::vector<Value> values;
+      values.emplace_back(TypeId::INTEGER, i);
+      values.emplace_back(TypeId::VARCHAR, name.c_str(), name.size() + 1,
+                          true);
+      values.emplace_back(TypeId::VARCHAR, city, strlen(city) + 1, true);
+      values.emplace_back(TypeId::BIGINT,
+                          static_cast<int64_t>(rng() % 10000000));
+      values.emplace_back(TypeId::BOOLEAN, static_cast<int8_t>(rng() % 2));
+      ASSERT_EQ(true,
+                table->InsertTuple(Tuple(values, schema), rid, transaction));
+    }
+    page_id_t first_page_id = table->GetFirstPageId();
+    delete table;
+    buffer_pool_manager->FlushAllPages();
+    delete buffer_pool_manager;
+    struct stat stat_buf;
+    file_size[compress] =
+        stat("test.db", &stat_buf) == 0 ? stat_buf.st_size : 0;
+    if (stat("test.map", &stat_buf) == 0) {
+      file_size[compress] += stat_buf.st_size;
+    }
+
+    buffer_pool_manager = new BufferPoolManager(16, disk_manager);
+    table = new TableHeap(buffer_pool_manager, lock_manager, log_manager,
+                          first_page_id);
+    auto start = std::chrono::steady_clock::now();
+    int count = 0;
+    for (int scan = 0; scan < num_scans; ++scan) {
+      for (auto itr = table->begin(transaction); itr != table->end(); ++itr) {
+        count++;
+      }
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(num_tuples * num_scans, count);
+    scan_rate[compress] = count / elapsed.count();
+    delete table;
+    delete buffer_pool_manager;
+    delete log_manager;
+    delete disk_manager;
+  }
+  printf("%-10s %12s %16s\n", "format", "size (KB)", "scan (tuples/s)");
+  const char *formats[] = {"raw", "compressed"};
+  for (int compress = 0; compress < 2; ++compress) {
+    printf("%-10s %12lld %16.0f\n", formats[compress],
+           static_cast<long long>(file_size[compress] / 1024),
+           scan_rate[compress]);
+  }
+  EXPECT_GT(file_size[0], file_size[1]);
+
+  delete lock_manager;
+  delete transaction;
+  delete schema;
+  remove("test.db");
+  remove("test.map");
+  remove("test.log");
+}
+
 } // namespace scudb